@@ -0,0 +1,51 @@
+"""
+    Simple client for the solver daemon (./gal serve <socket-path>)
+    Usage: python3 ./serve-client.py <socket-path> <instance.xml> [algorithm] [output] [repeat]
+    Sends the instance (repeat times over one connection) and prints the responses with the round-trip times.
+"""
+
+import socket
+import struct
+import sys
+from time import perf_counter
+
+
+def _read_exactly(connection, size):
+    data = b''
+    while len(data) < size:
+        chunk = connection.recv(size - len(data))
+        if not chunk:
+            raise ConnectionError('The server closed the connection')
+        data += chunk
+    return data
+
+
+def solve(connection, instance, algorithm='genetic', output='json'):
+    payload = f'algorithm {algorithm}\noutput {output}\n\n'.encode() + instance
+    connection.sendall(struct.pack('!I', len(payload)) + payload)
+    length = struct.unpack('!I', _read_exactly(connection, 4))[0]
+    status, _, body = _read_exactly(connection, length).decode().partition('\n')
+    return status, body
+
+
+if len(sys.argv) < 3:
+    print(__doc__, file=sys.stderr)
+    exit(1)
+
+socket_path = sys.argv[1]
+with open(sys.argv[2], 'rb') as f:
+    instance = f.read()
+algorithm = sys.argv[3] if len(sys.argv) > 3 else 'genetic'
+output = sys.argv[4] if len(sys.argv) > 4 else 'json'
+repeat = int(sys.argv[5]) if len(sys.argv) > 5 else 1
+
+with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as connection:
+    connection.connect(socket_path)
+    for i in range(repeat):
+        start = perf_counter()
+        status, body = solve(connection, instance, algorithm, output)
+        elapsed = (perf_counter() - start) * 1000
+        print(body, end='')
+        print(f'[{i + 1}/{repeat}] {status} in {elapsed:.2f} ms', file=sys.stderr)
+        if status != 'ok':
+            exit(1)
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include "batch.hpp"
+#include "solver.hpp"
+#include "threadpool.hpp"
+
+vector<string> collectInstances(const string& source) {
+    vector<string> instances;
+    if (filesystem::is_directory(source)) {
+        for (auto& entry : filesystem::directory_iterator(source)) {
+            if (entry.is_regular_file() and entry.path().extension() == ".xml") {
+                instances.push_back(entry.path().string());
+            }
+        }
+    } else {
+        ifstream list(source);
+        if (!list) {
+            throw runtime_error("Cannot open the list of instances " + source);
+        }
+        string line;
+        while (getline(list, line)) {
+            // skip empty lines and comments
+            if (!line.empty() and line[0] != '#') {
+                instances.push_back(line);
+            }
+        }
+    }
+    sort(instances.begin(), instances.end());
+    return instances;
+}
+
+/**
+ * The work of both algorithms grows with the square of the number of nodes (distance matrix, crossover)
+ * and the size of the XML file is proportional to the number of nodes, so it is used to weight the tasks
+ * without having to parse the instances first.
+ */
+static double estimateWeight(const string& path) {
+    error_code error;
+    auto size = filesystem::file_size(path, error);
+    if (error) {
+        return 1.0;
+    }
+    return (double)size * size;
+}
+
+void printSolution(const Solution& solution, const string& format) {
+    if (format == "json") {
+        solution.printJson();
+    } else if (format == "csv") {
+        solution.printCsv();
+    } else {
+        solution.printOut();
+    }
+}
+
+int runBatch(const vector<string>& instances, const SolverOptions& options, size_t jobs, const string& format) {
+    mutex outputLock;
+    int failed = 0;
+
+    if (format == "csv") {
+        cout << Solution::csvHeader() << endl;
+    }
+    {
+        ThreadPool pool(jobs);
+        for (auto& path : instances) {
+            pool.submit([&, path] {
+                try {
+                    Solution solution = Solver::solveFile(path, options);
+                    lock_guard<mutex> guard(outputLock);
+                    printSolution(solution, format);
+                    cout.flush();
+                } catch (const exception& e) {
+                    lock_guard<mutex> guard(outputLock);
+                    cerr << path << ": " << e.what() << endl;
+                    failed++;
+                }
+            }, estimateWeight(path));
+        }
+        pool.wait();
+    }
+    return failed;
+}
@@ -0,0 +1,39 @@
+/**
+ * Batch mode - solves many instances inside one process on a work-stealing thread pool
+**/
+
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <string>
+#include <vector>
+#include "solver.hpp"
+
+using namespace std;
+
+/**
+ * Collects the instances to be solved in batch mode.
+ * @param source either a directory (all *.xml files inside are used) or a text file with one path per line
+ * @return paths to the instances sorted by name
+ */
+vector<string> collectInstances(const string& source);
+
+/**
+ * Prints the solution to the standard output in the given format.
+ * @param solution the solution to be printed
+ * @param format one of 'text' (human-readable), 'json' (one object per line) or 'csv' (one row, without header)
+ */
+void printSolution(const Solution& solution, const string& format);
+
+/**
+ * Solves all the instances in parallel and prints one record per instance to the standard output as soon
+ * as the instance is solved. Instances that fail to load are reported on the standard error output.
+ * @param instances paths to the instances
+ * @param options options of the solver used for every instance
+ * @param jobs number of worker threads, 0 means one per hardware thread
+ * @param format output format of the records ('csv'|'json'), the CSV output starts with a header
+ * @return number of instances that could not be solved
+ */
+int runBatch(const vector<string>& instances, const SolverOptions& options, size_t jobs, const string& format);
+
+#endif //BATCH_HPP
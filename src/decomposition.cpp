@@ -0,0 +1,403 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include "decomposition.hpp"
+#include "fleet.hpp"
+#include "genetic.hpp"
+#include "random.hpp"
+#include "threadpool.hpp"
+#include "timewindows.hpp"
+#include "timing.hpp"
+
+static const int KMEANS_ITERATIONS = 50;
+// Parts with at most this many customers are solved exactly by solveDirectly(), the metaheuristics have nothing to
+// search there
+static const size_t DIRECT_PART_SIZE = 4;
+
+bool isDecomposition(const string& method) {
+    return method == "sectors" or method == "kmeans";
+}
+
+// Angle of the node around the depot
+static double angle(const Problem& problem, int index) {
+    return atan2(problem.nodes[index].y - problem.nodes[0].y, problem.nodes[index].x - problem.nodes[0].x);
+}
+
+vector<vector<int>> sectorClusters(const Problem& problem, size_t clusterSize) {
+    size_t n = problem.nodes.size() - 1;
+    vector<int> customers(n);
+    iota(customers.begin(), customers.end(), 1);
+    vector<double> angles(problem.nodes.size());
+    for (auto& customer : customers) {
+        angles[customer] = angle(problem, customer);
+    }
+    sort(customers.begin(), customers.end(), [&](int a, int b) {
+        return angles[a] < angles[b] or (angles[a] == angles[b] and a < b);
+    });
+
+    // the sectors start after the largest gap, so a dense part of the plane is not cut needlessly
+    size_t start = 0;
+    double largestGap = n > 0 ? angles[customers[0]] + 2 * M_PI - angles[customers[n-1]] : 0;
+    for (size_t i = 1; i < n; i++) {
+        double gap = angles[customers[i]] - angles[customers[i-1]];
+        if (gap > largestGap) {
+            largestGap = gap;
+            start = i;
+        }
+    }
+    rotate(customers.begin(), customers.begin() + start, customers.end());
+
+    size_t count = max((n + clusterSize - 1) / clusterSize, (size_t)1);
+    vector<vector<int>> clusters(count);
+    for (size_t i = 0; i < n; i++) {
+        clusters[i * count / n].push_back(customers[i]);
+    }
+    return clusters;
+}
+
+vector<vector<int>> kmeansClusters(const Problem& problem, size_t clusterSize) {
+    vector<vector<int>> sectors = sectorClusters(problem, clusterSize);
+    size_t count = sectors.size();
+    vector<double> centerX(count), centerY(count);
+    auto updateCenters = [&](const vector<vector<int>>& clusters) {
+        for (size_t c = 0; c < count; c++) {
+            if (clusters[c].empty()) {
+                continue; // the center stays where it was
+            }
+            double x = 0, y = 0;
+            for (auto& customer : clusters[c]) {
+                x += problem.nodes[customer].x;
+                y += problem.nodes[customer].y;
+            }
+            centerX[c] = x / clusters[c].size();
+            centerY[c] = y / clusters[c].size();
+        }
+    };
+    updateCenters(sectors);
+
+    vector<int> clusterOf(problem.nodes.size(), -1);
+    vector<vector<int>> clusters(count);
+    for (int iteration = 0; iteration < KMEANS_ITERATIONS; iteration++) {
+        bool changed = false;
+        for (auto& cluster : clusters) {
+            cluster.clear();
+        }
+        for (size_t customer = 1; customer < problem.nodes.size(); customer++) {
+            auto& node = problem.nodes[customer];
+            int nearest = 0;
+            double nearestDistance = numeric_limits<double>::infinity();
+            for (size_t c = 0; c < count; c++) {
+                double distance = (node.x - centerX[c]) * (node.x - centerX[c]) + (node.y - centerY[c]) * (node.y - centerY[c]);
+                if (distance < nearestDistance) {
+                    nearestDistance = distance;
+                    nearest = c;
+                }
+            }
+            changed = changed or clusterOf[customer] != nearest;
+            clusterOf[customer] = nearest;
+            clusters[nearest].push_back(customer);
+        }
+        if (!changed) {
+            break;
+        }
+        updateCenters(clusters);
+    }
+    clusters.erase(remove_if(clusters.begin(), clusters.end(), [](const vector<int>& cluster) { return cluster.empty(); }),
+                   clusters.end());
+    return clusters;
+}
+
+namespace {
+    // Distance of a route and its time warp
+    struct RouteCost {
+        double distance = 0;
+        double timeWarp = 0;
+    };
+
+    // Routes of a part of the problem (original node IDs) with their costs
+    struct PartResult {
+        vector<vector<int>> routes;
+        vector<RouteCost> costs;
+        Solution solution;
+    };
+}
+
+// Cost of the routes compared by the boundary re-optimization, the time warp is penalized as in the algorithms
+static double totalCost(const vector<RouteCost>& costs) {
+    double total = 0;
+    for (auto& cost : costs) {
+        total += cost.distance + cost.timeWarp * TIME_WARP_PENALTY;
+    }
+    return total;
+}
+
+// Adds the durations of the phases of the part to the solution
+static void addTimes(Solution& solution, const Solution& part) {
+    solution.matrixTime.wall += part.matrixTime.wall;
+    solution.matrixTime.cpu += part.matrixTime.cpu;
+    solution.constructTime.wall += part.constructTime.wall;
+    solution.constructTime.cpu += part.constructTime.cpu;
+    solution.improveTime.wall += part.improveTime.wall;
+    solution.improveTime.cpu += part.improveTime.cpu;
+}
+
+/**
+ * Solves a tiny part exactly: every order of its customers is split into routes by splitFleet() and the cheapest
+ * split is kept, with the excess vehicles and the time warp penalized like in the genetic algorithm
+ * Time complexity: O(c! * c^2 * T) for c <= DIRECT_PART_SIZE customers and T vehicle types
+ * Space complexity: O(c)
+ * @param part the single-depot part of the problem
+ * @param options options of the part (the fleet)
+ * @param matrix distances between the nodes of the part
+*/
+static Solution solveDirectly(const Problem& part, const SolverOptions& options, const DistanceMatrix& matrix) {
+    auto algorithmStart = chrono::high_resolution_clock::now();
+    PhaseTimer constructTimer;
+    Fleet fleet = Solver::fleet(part, options);
+    vector<int> tour(part.requests.size());
+    iota(tour.begin(), tour.end(), 2);
+    FleetSplit best;
+    double bestCost = numeric_limits<double>::infinity();
+    do {
+        FleetSplit split = splitFleet(tour, part.requests, fleet, matrix, true);
+        double cost = split.distance + split.excessVehicles * excessVehiclePenalty(tour, matrix) +
+                      split.timeWarp * TIME_WARP_PENALTY;
+        if (cost < bestCost - 1e-9) {
+            bestCost = cost;
+            best = move(split);
+        }
+    } while (next_permutation(tour.begin(), tour.end()));
+
+    Solution solution;
+    solution.algorithm = options.algorithm;
+    solution.routes = best.routes;
+    solution.distance = best.distance;
+    if (!fleet.isUniform()) {
+        for (auto& type : best.types) {
+            solution.capacities.push_back(fleet.types[type].capacity);
+        }
+    }
+    solution.constructTime = constructTimer.elapsed();
+    solution.algorithmTime = chrono::duration_cast<chrono::microseconds>(chrono::high_resolution_clock::now()
+                                                                          - algorithmStart).count();
+    solution.calculateStatistics(part.requests, fleet.maxCapacity());
+    return solution;
+}
+
+/**
+ * Solves the single-depot problem made of the depot and the given customers
+ * The nodes are renumbered from 1 (the depot), the routes are mapped back to the original node IDs. A part of at most
+ * DIRECT_PART_SIZE customers is solved directly instead of by the algorithm of the options.
+ * Time complexity: the complexity of the algorithm on the part (plus O(c^2) for its distance matrix)
+ * Space complexity: O(c^2) for c customers of the part
+ * @param seed seed of the random numbers of the part, derived from the seed of the options and the index of the part
+ * @param explicitMatrix the explicit distance matrix of the whole problem sliced for the part, null to calculate
+ *                       the matrix of the part
+ * @param previous routes of the same customers to compare with (original node IDs), their costs are stored
+ *                 into previousCosts
+*/
+static PartResult solvePart(const Problem& problem, const vector<int>& customers, const SolverOptions& options,
+                            uint64_t seed, const DistanceMatrix* explicitMatrix, const vector<vector<int>>* previous,
+                            vector<RouteCost>* previousCosts) {
+    Problem part;
+    part.name = problem.name;
+    part.vehicles = problem.vehicles;
+    part.nodes.push_back(problem.nodes[0]);
+    vector<int> partId(problem.nodes.size(), 0);
+    for (auto& customer : customers) {
+        Node node = problem.nodes[customer];
+        node.id = part.nodes.size() + 1;
+        partId[customer] = node.id;
+        part.nodes.push_back(node);
+        Request request = problem.requests[customer - 1];
+        request.whereto = node;
+        part.requests.push_back(request);
+    }
+
+    SolverOptions partOptions = options;
+    partOptions.decomposition.clear();
+    partOptions.seed = seed;
+    PhaseTimer matrixTimer;
+    vector<int> indices = {0};
+    indices.insert(indices.end(), customers.begin(), customers.end());
+    DistanceMatrix matrix = explicitMatrix ? explicitMatrix->slice(indices) : Solver::distanceMatrix(part, partOptions);
+    auto matrixTime = matrixTimer.elapsed();
+    double horizon = problem.vehicles[0].maxTravelTime;
+    bool timeWindows = hasTimeWindows(part.requests) or !isinf(horizon);
+    auto routeCost = [&](const vector<int>& route) {
+        RouteCost cost;
+        cost.distance = calculateCustomerDistance(route, matrix);
+        cost.timeWarp = timeWindows ? routeTimeWarp(route, part.requests, horizon, matrix) : 0;
+        return cost;
+    };
+
+    PartResult result;
+    result.solution = customers.size() <= DIRECT_PART_SIZE ? solveDirectly(part, partOptions, matrix)
+                                                           : Solver::solve(part, partOptions, matrix);
+    result.solution.matrixTime = matrixTime;
+    for (auto& route : result.solution.routes) {
+        result.costs.push_back(routeCost(route));
+        for (auto& customer : route) {
+            customer = customers[customer - 2] + 1; // back to the original node ID
+        }
+        result.routes.push_back(route);
+    }
+    if (previous) {
+        for (auto& route : *previous) {
+            vector<int> renumbered;
+            for (auto& customer : route) {
+                renumbered.push_back(partId[customer - 1]);
+            }
+            previousCosts->push_back(routeCost(renumbered));
+        }
+    }
+    return result;
+}
+
+/**
+ * Solves the parts in parallel on the thread pool, the largest parts are started first
+ * The first exception thrown by a part is thrown again after all parts finish.
+*/
+static vector<PartResult> solveParts(const Problem& problem, const vector<vector<int>>& parts, const SolverOptions& options,
+                                     const DistanceMatrix* explicitMatrix,
+                                     const vector<vector<vector<int>>>* previous = nullptr,
+                                     vector<vector<RouteCost>>* previousCosts = nullptr) {
+    vector<PartResult> results(parts.size());
+    vector<exception_ptr> errors(parts.size());
+    {
+        ThreadPool pool(options.threads);
+        for (size_t p = 0; p < parts.size(); p++) {
+            pool.submit([&, p]() {
+                try {
+                    results[p] = solvePart(problem, parts[p], options, streamSeed(options.seed, p), explicitMatrix, previous ? &(*previous)[p] : nullptr,
+                                           previousCosts ? &(*previousCosts)[p] : nullptr);
+                } catch (...) {
+                    errors[p] = current_exception();
+                }
+            }, (double)parts[p].size() * parts[p].size());
+        }
+        pool.wait();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+    return results;
+}
+
+/**
+ * Groups the routes by the angle of their center around the depot into groups of about the cluster size,
+ * the first group starts in the middle of the first cluster, so every group spans a border between two clusters
+ * Time complexity: O(r log r + n) for r routes
+*/
+static vector<vector<int>> boundaryGroups(const Problem& problem, const vector<vector<int>>& routes, size_t clusterSize) {
+    vector<double> angles;
+    for (auto& route : routes) {
+        double x = 0, y = 0;
+        for (auto& customer : route) {
+            x += problem.nodes[customer-1].x;
+            y += problem.nodes[customer-1].y;
+        }
+        angles.push_back(atan2(y / route.size() - problem.nodes[0].y, x / route.size() - problem.nodes[0].x));
+    }
+    vector<int> order(routes.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](int a, int b) { return angles[a] < angles[b] or (angles[a] == angles[b] and a < b); });
+
+    size_t start = 0;
+    for (size_t covered = 0; start < order.size() and covered + routes[order[start]].size() <= clusterSize / 2; start++) {
+        covered += routes[order[start]].size();
+    }
+    rotate(order.begin(), order.begin() + (start < order.size() ? start : 0), order.end());
+
+    vector<vector<int>> groups(1);
+    size_t size = 0;
+    for (auto& route : order) {
+        if (size >= clusterSize) {
+            groups.emplace_back();
+            size = 0;
+        }
+        groups.back().push_back(route);
+        size += routes[route].size();
+    }
+    return groups;
+}
+
+Solution solveDecomposed(const Problem& problem, const SolverOptions& options) {
+    if (problem.depotCount() > 1) {
+        throw invalid_argument("The decomposition is not supported with multiple depots");
+    }
+    if (options.heterogeneousFleet or options.maxVehicles != 0) {
+        throw invalid_argument("The decomposition does not support a limited number of vehicles");
+    }
+    if (options.clusterSize == 0) {
+        throw invalid_argument("The size of the clusters must be positive");
+    }
+    // TIMESTAMP: Record time before the algorithm starts
+    auto algorithmStart = chrono::high_resolution_clock::now();
+    Solver::fleet(problem, options); // checks that every request fits into the vehicle
+    // the explicit matrix is mapped from the file only once and sliced for the parts
+    optional<DistanceMatrix> explicitMatrix;
+    if (!options.distanceMatrix.empty()) {
+        explicitMatrix.emplace(Solver::distanceMatrix(problem, options));
+    }
+    const DistanceMatrix* matrix = explicitMatrix ? &*explicitMatrix : nullptr;
+
+    Solution solution;
+    vector<vector<int>> clusters = options.decomposition == "kmeans" ? kmeansClusters(problem, options.clusterSize)
+                                                                     : sectorClusters(problem, options.clusterSize);
+    vector<vector<int>> routes;
+    vector<RouteCost> costs;
+    for (auto& part : solveParts(problem, clusters, options, matrix)) {
+        routes.insert(routes.end(), part.routes.begin(), part.routes.end());
+        costs.insert(costs.end(), part.costs.begin(), part.costs.end());
+        addTimes(solution, part.solution);
+    }
+
+    if (options.boundaryReoptimization and clusters.size() > 1) {
+        // the routes along the borders are solved again together, a group is replaced only if it gets cheaper
+        vector<vector<int>> groups = boundaryGroups(problem, routes, options.clusterSize);
+        vector<vector<int>> groupCustomers(groups.size());
+        vector<vector<vector<int>>> previous(groups.size());
+        for (size_t g = 0; g < groups.size(); g++) {
+            for (auto& route : groups[g]) {
+                for (auto& customer : routes[route]) {
+                    groupCustomers[g].push_back(customer - 1); // node index
+                }
+                previous[g].push_back(routes[route]);
+            }
+        }
+        vector<vector<RouteCost>> previousCosts(groups.size());
+        vector<PartResult> reoptimized = solveParts(problem, groupCustomers, options, matrix, &previous, &previousCosts);
+
+        routes.clear();
+        costs.clear();
+        for (size_t g = 0; g < groups.size(); g++) {
+            bool improved = totalCost(reoptimized[g].costs) < totalCost(previousCosts[g]) - 1e-9;
+            auto& kept = improved ? reoptimized[g].routes : previous[g];
+            auto& keptCosts = improved ? reoptimized[g].costs : previousCosts[g];
+            routes.insert(routes.end(), kept.begin(), kept.end());
+            costs.insert(costs.end(), keptCosts.begin(), keptCosts.end());
+            addTimes(solution, reoptimized[g].solution);
+        }
+    }
+
+    // TIMESTAMP: record the time after the algorithm ends and calculate its duration
+    auto algorithmEnd = chrono::high_resolution_clock::now();
+    solution.algorithm = options.algorithm;
+    solution.routes = routes;
+    for (auto& cost : costs) {
+        solution.distance += cost.distance;
+        solution.timeWarp += cost.timeWarp;
+    }
+    solution.timeWindows = hasTimeWindows(problem.requests) or !isinf(problem.vehicles[0].maxTravelTime);
+    solution.algorithmTime = chrono::duration_cast<chrono::microseconds>(algorithmEnd - algorithmStart).count();
+    solution.calculateStatistics(problem.requests, problem.vehicleCapacity());
+    solution.instance = problem.name;
+    return solution;
+}
@@ -0,0 +1,61 @@
+/**
+ * Cluster-first route-second decomposition of large instances
+ * The customers are split into clusters of about the same size, either angular sectors around the depot or
+ * k-means clusters of their coordinates. Every cluster is a separate single-depot problem with its own distance
+ * matrix solved by the chosen algorithm, the clusters are solved in parallel on the thread pool and their routes
+ * are joined. The matrix of the whole instance is never built, so the memory and the time grow with the square
+ * of the cluster size instead of the square of the instance size.
+ * The optional boundary re-optimization groups the finished routes again by their angle around the depot, with
+ * the groups shifted by half of a cluster, so the routes on both sides of a border are solved together. A group
+ * is kept only if it got cheaper.
+**/
+
+#ifndef DECOMPOSITION_HPP
+#define DECOMPOSITION_HPP
+
+#include "../structures/Problem.hpp"
+#include "../structures/Solution.hpp"
+#include "solver.hpp"
+
+using namespace std;
+
+/**
+ * Checks whether the decomposition method is known.
+ * @param method name of the method
+ * @return true for 'sectors' and 'kmeans'
+ */
+bool isDecomposition(const string& method);
+
+/**
+ * Splits the customers into angular sectors around the depot with the same number of customers, the first
+ * sector starts after the largest angular gap between the customers.
+ * Time complexity: O(n log n)
+ * Space complexity: O(n)
+ * @param problem the problem with a single depot
+ * @param clusterSize the largest number of customers of a sector
+ * @return node indices of the customers of every sector
+ */
+vector<vector<int>> sectorClusters(const Problem& problem, size_t clusterSize);
+
+/**
+ * Splits the customers into clusters by the k-means algorithm on their coordinates, the clusters start as
+ * the centers of the sectors (so the result is deterministic).
+ * Time complexity: O(i * n * k) for i iterations and k clusters
+ * Space complexity: O(n + k)
+ * @param problem the problem with a single depot
+ * @param clusterSize the average number of customers of a cluster
+ * @return node indices of the customers of every cluster, empty clusters are left out
+ */
+vector<vector<int>> kmeansClusters(const Problem& problem, size_t clusterSize);
+
+/**
+ * Solves the problem by the decomposition chosen in the options (SolverOptions::decomposition), the clusters
+ * are solved with the algorithm of the options.
+ * @param problem the problem with a single depot
+ * @param options options of the solver
+ * @return the joined solution of the clusters
+ * @throws invalid_argument if the problem has several depots or the options limit the vehicles
+ */
+Solution solveDecomposed(const Problem& problem, const SolverOptions& options);
+
+#endif //DECOMPOSITION_HPP
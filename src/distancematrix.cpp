@@ -0,0 +1,347 @@
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "distancematrix.hpp"
+#include "util.hpp"
+
+static const char MAGIC[8] = {'G', 'A', 'L', 'D', 'M', '0', '1', '\0'};
+
+// Header of the stored matrix, the elements follow it row by row
+struct MatrixFileHeader {
+    char magic[8];
+    uint32_t precision;
+    uint32_t layout;
+    uint64_t nodes;
+    uint64_t hash;
+};
+
+struct DistanceMatrix::Storage {
+    vector<double> owned;       // doubles to get the alignment suitable for both precisions
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+
+    ~Storage() {
+        if (mapping != nullptr) {
+            munmap(mapping, mappingSize);
+        }
+    }
+};
+
+static size_t elementSize(MatrixPrecision precision) {
+    return precision == MatrixPrecision::Double ? sizeof(double) : precision == MatrixPrecision::Float ? sizeof(float) : sizeof(int32_t);
+}
+
+double roundDistance(double distance, DistanceRounding rounding) {
+    switch (rounding) {
+        case DistanceRounding::Nearest:
+            return floor(distance + 0.5); // nint() of TSPLIB
+        case DistanceRounding::Floor:
+            return floor(distance);
+        case DistanceRounding::Ceil:
+            return ceil(distance);
+        default:
+            return distance;
+    }
+}
+
+static size_t elementCount(size_t nodes, MatrixLayout layout) {
+    return layout == MatrixLayout::Full ? nodes * nodes : nodes * (nodes + 1) / 2;
+}
+
+DistanceMatrix::DistanceMatrix() {
+    data = nullptr;
+    nodes = 0;
+    stride = 0;
+    type = MatrixPrecision::Double;
+}
+
+DistanceMatrix::DistanceMatrix(size_t size, MatrixPrecision precision, MatrixLayout layout) {
+    nodes = size;
+    type = precision;
+    stride = layout == MatrixLayout::Full ? size : 0;
+    storage = make_shared<Storage>();
+    size_t bytes = ::elementCount(size, layout) * elementSize(precision);
+    storage->owned.assign((bytes + sizeof(double) - 1) / sizeof(double), 0.0);
+    data = reinterpret_cast<const unsigned char*>(storage->owned.data());
+}
+
+/**
+ * The distance is symmetrical, so only the upper triangle is calculated and mirrored
+ * Time complexity: O(n^2 / 2)
+ */
+DistanceMatrix DistanceMatrix::euclidean(const vector<Node>& nodes, MatrixPrecision precision, DistanceRounding rounding) {
+    if (precision == MatrixPrecision::Int32 and rounding == DistanceRounding::None) {
+        rounding = DistanceRounding::Nearest;
+    }
+    DistanceMatrix matrix(nodes.size(), precision);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        int row = nodes[i].id - 1; // Node IDs start with 1 (the depot), need to lower this to start indexing from 0
+        for (size_t j = i + 1; j < nodes.size(); j++) {
+            int column = nodes[j].id - 1;
+            double dist = roundDistance(distance(nodes[i], nodes[j]), rounding);
+            matrix.set(row, column, dist);
+            matrix.set(column, row, dist);
+        }
+    }
+    return matrix;
+}
+
+void DistanceMatrix::set(size_t row, size_t column, double distance) {
+    if (!storage or storage->mapping != nullptr or storage.use_count() > 1) {
+        throw logic_error("Only an owned and unshared distance matrix can be modified");
+    }
+    size_t index = elementIndex(row, column, stride);
+    auto elements = const_cast<unsigned char*>(data);
+    if (type == MatrixPrecision::Double) {
+        reinterpret_cast<double*>(elements)[index] = distance;
+    } else if (type == MatrixPrecision::Float) {
+        reinterpret_cast<float*>(elements)[index] = distance;
+    } else {
+        reinterpret_cast<int32_t*>(elements)[index] = (int32_t)llround(distance);
+    }
+}
+
+DistanceMatrix DistanceMatrix::slice(const vector<int>& indices) const {
+    DistanceMatrix matrix(indices.size(), type);
+    for (size_t i = 0; i < indices.size(); i++) {
+        auto row = (*this)[indices[i]];
+        for (size_t j = 0; j < indices.size(); j++) {
+            matrix.set(i, j, row[indices[j]]);
+        }
+    }
+    return matrix;
+}
+
+size_t DistanceMatrix::size() const {
+    return nodes;
+}
+
+MatrixPrecision DistanceMatrix::precision() const {
+    return type;
+}
+
+MatrixLayout DistanceMatrix::layout() const {
+    return stride == 0 and nodes > 0 ? MatrixLayout::Triangular : MatrixLayout::Full;
+}
+
+size_t DistanceMatrix::elementCount() const {
+    return ::elementCount(nodes, layout());
+}
+
+bool DistanceMatrix::isMapped() const {
+    return storage and storage->mapping != nullptr;
+}
+
+/**
+ * Maps the whole file and checks the header, the hash is not checked if expectedHash is null
+ */
+DistanceMatrix DistanceMatrix::mapFile(const string& path, const uint64_t* expectedHash, string& error) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = strerror(errno);
+        return DistanceMatrix();
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0 or (size_t)info.st_size < sizeof(MatrixFileHeader)) {
+        close(fd);
+        error = "the file is too short";
+        return DistanceMatrix();
+    }
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping stays valid after closing the file
+    if (mapping == MAP_FAILED) {
+        error = strerror(errno);
+        return DistanceMatrix();
+    }
+    size_t mappingSize = info.st_size;
+
+    // the storage owns the mapping from now on, it is unmapped when the last copy of the matrix is gone
+    auto storage = make_shared<Storage>();
+    storage->mapping = mapping;
+    storage->mappingSize = mappingSize;
+
+    MatrixFileHeader header;
+    memcpy(&header, mapping, sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 or header.precision > 2 or header.layout > 1) {
+        error = "not a distance matrix in the binary format";
+        return DistanceMatrix();
+    }
+    if (expectedHash != nullptr and header.hash != *expectedHash) {
+        error = "the matrix belongs to different nodes";
+        return DistanceMatrix();
+    }
+    auto precision = static_cast<MatrixPrecision>(header.precision);
+    auto layout = static_cast<MatrixLayout>(header.layout);
+    if (mappingSize != sizeof(header) + ::elementCount(header.nodes, layout) * elementSize(precision)) {
+        error = "the file is truncated or corrupted";
+        return DistanceMatrix();
+    }
+
+    DistanceMatrix matrix;
+    matrix.storage = storage;
+    matrix.data = static_cast<const unsigned char*>(mapping) + sizeof(header);
+    matrix.nodes = header.nodes;
+    matrix.stride = layout == MatrixLayout::Full ? header.nodes : 0;
+    matrix.type = precision;
+    return matrix;
+}
+
+DistanceMatrix DistanceMatrix::map(const string& path, uint64_t expectedHash) {
+    string error;
+    return mapFile(path, &expectedHash, error);
+}
+
+void DistanceMatrix::save(const string& path, uint64_t hash) const {
+    MatrixFileHeader header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.precision = static_cast<uint32_t>(type);
+    header.layout = static_cast<uint32_t>(layout());
+    header.nodes = nodes;
+    header.hash = hash;
+
+    // unique temporary name so that concurrent writers (batch mode, server) do not clash
+    ostringstream temporary;
+    temporary << path << ".tmp." << getpid() << "." << std::hash<thread::id>{}(this_thread::get_id());
+    {
+        ofstream file(temporary.str(), ios::binary | ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data), elementCount() * elementSize(type));
+        if (!file) {
+            filesystem::remove(temporary.str());
+            throw runtime_error("Cannot write the distance matrix to " + path);
+        }
+    }
+    filesystem::rename(temporary.str(), path);
+}
+
+DistanceMatrix DistanceMatrix::cached(const vector<Node>& nodes, MatrixPrecision precision, DistanceRounding rounding,
+                                     const string& cacheDirectory) {
+    static const char* roundingNames[] = {"", "-nint", "-floor", "-ceil"};
+    static const char* precisionNames[] = {"-f64", "-f32", "-i32"};
+    if (precision == MatrixPrecision::Int32 and rounding == DistanceRounding::None) {
+        rounding = DistanceRounding::Nearest;
+    }
+    string metric = string("euclidean") + roundingNames[(int)rounding];
+    uint64_t hash = hashCoordinates(nodes);
+    hash = hashBytes(metric.data(), metric.size(), hash);
+    hash = hashBytes(&precision, sizeof(precision), hash);
+
+    ostringstream name;
+    name << hex << setw(16) << setfill('0') << hash << "-" << metric << precisionNames[(int)precision] << ".dm";
+    string path = (filesystem::path(cacheDirectory) / name.str()).string();
+
+    DistanceMatrix matrix = map(path, hash);
+    if (matrix.size() == nodes.size()) {
+        return matrix;
+    }
+
+    matrix = euclidean(nodes, precision, rounding);
+    try {
+        filesystem::create_directories(cacheDirectory);
+        matrix.save(path, hash);
+        DistanceMatrix mapped = map(path, hash);
+        if (mapped.size() == nodes.size()) {
+            return mapped; // share the page cache with other processes instead of keeping a private copy
+        }
+    } catch (const exception&) {
+        // the cache is only an optimization, the calculated matrix is used if it cannot be stored
+    }
+    return matrix;
+}
+
+DistanceMatrix DistanceMatrix::load(const string& path, MatrixPrecision precision, DistanceRounding rounding) {
+    char magic[sizeof(MAGIC)] = {};
+    {
+        ifstream file(path, ios::binary);
+        if (!file) {
+            throw runtime_error("Cannot open the distance matrix " + path);
+        }
+        file.read(magic, sizeof(magic));
+    }
+    if (memcmp(magic, MAGIC, sizeof(MAGIC)) == 0) {
+        string error;
+        DistanceMatrix matrix = mapFile(path, nullptr, error);
+        if (matrix.size() == 0) {
+            throw runtime_error("Cannot map the distance matrix " + path + ": " + error);
+        }
+        return matrix;
+    }
+    return parseTsplib(path, precision, rounding);
+}
+
+/**
+ * Function to parse the TSPLIB file, only the specification part and the EDGE_WEIGHT_SECTION are used
+ * Time complexity: O(n^2) - every element is read once
+ */
+DistanceMatrix DistanceMatrix::parseTsplib(const string& path, MatrixPrecision precision, DistanceRounding rounding) {
+    ifstream file(path);
+    if (!file) {
+        throw runtime_error("Cannot open the distance matrix " + path);
+    }
+
+    size_t dimension = 0;
+    string weightType;
+    string weightFormat = "FULL_MATRIX";
+    string line;
+    bool weightSection = false;
+    while (getline(file, line)) {
+        auto colon = line.find(':');
+        string keyword = line.substr(0, colon);
+        keyword.erase(keyword.find_last_not_of(" \t\r") + 1);
+        keyword.erase(0, keyword.find_first_not_of(" \t"));
+        string value = colon == string::npos ? "" : line.substr(colon + 1);
+        value.erase(value.find_last_not_of(" \t\r") + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+
+        if (keyword == "DIMENSION") {
+            dimension = stoul(value);
+        } else if (keyword == "EDGE_WEIGHT_TYPE") {
+            weightType = value;
+        } else if (keyword == "EDGE_WEIGHT_FORMAT") {
+            weightFormat = value;
+        } else if (keyword == "EDGE_WEIGHT_SECTION") {
+            weightSection = true;
+            break;
+        }
+    }
+    if (!weightSection or dimension == 0 or weightType != "EXPLICIT") {
+        throw runtime_error("The TSPLIB file " + path + " has to specify DIMENSION, EDGE_WEIGHT_TYPE: EXPLICIT and EDGE_WEIGHT_SECTION");
+    }
+
+    // The column-wise formats of a symmetric matrix are the row-wise formats of its transposition
+    bool full = weightFormat == "FULL_MATRIX";
+    bool upper = weightFormat == "UPPER_ROW" or weightFormat == "UPPER_DIAG_ROW"
+                 or weightFormat == "LOWER_COL" or weightFormat == "LOWER_DIAG_COL";
+    bool lower = weightFormat == "LOWER_ROW" or weightFormat == "LOWER_DIAG_ROW"
+                 or weightFormat == "UPPER_COL" or weightFormat == "UPPER_DIAG_COL";
+    bool diagonal = weightFormat.find("DIAG") != string::npos;
+    if (!full and !upper and !lower) {
+        throw runtime_error("Unsupported EDGE_WEIGHT_FORMAT " + weightFormat + " in " + path);
+    }
+
+    DistanceMatrix matrix(dimension, precision, full ? MatrixLayout::Full : MatrixLayout::Triangular);
+    auto readWeight = [&]() {
+        double weight;
+        if (!(file >> weight)) {
+            throw runtime_error("The EDGE_WEIGHT_SECTION of " + path + " is incomplete");
+        }
+        return weight;
+    };
+    for (size_t i = 0; i < dimension; i++) {
+        size_t from = full ? 0 : upper ? (diagonal ? i : i + 1) : 0;
+        size_t to = full ? dimension : upper ? dimension : (diagonal ? i + 1 : i);
+        for (size_t j = from; j < to; j++) {
+            matrix.set(i, j, roundDistance(readWeight(), rounding));
+        }
+    }
+    return matrix;
+}
@@ -0,0 +1,232 @@
+/**
+ * Distance matrix stored in one contiguous block, either owned or memory-mapped from a file
+ * The elements are kept as doubles, floats (half the memory) or rounded 32-bit integers (exact sums comparable
+ * to the published results of the CVRPLIB instances, half the memory) and either as a full matrix or as
+ * a packed lower triangle including the diagonal (symmetric distances, half the memory again). Elements are
+ * accessed through matrix[i][j] regardless of the representation, so the algorithms do not need to know
+ * where the matrix came from. The matrix is immutable once built and copies share the same storage.
+ *
+ * Besides the euclidean distances, an explicit matrix (e.g. road distances) can be loaded from a file:
+ *   - the binary format written by save() is memory-mapped without copying (header followed by the elements),
+ *   - the TSPLIB format with EDGE_WEIGHT_TYPE: EXPLICIT is parsed (see convert-matrix in gal to turn it
+ *     into the binary format once and map it on every later run).
+**/
+
+#ifndef DISTANCEMATRIX_HPP
+#define DISTANCEMATRIX_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../structures/Node.hpp"
+
+using namespace std;
+
+enum class MatrixPrecision : uint32_t {
+    Double = 0,
+    Float = 1,
+    Int32 = 2,
+};
+
+// How the distances are rounded to integers (TSPLIB nint, floor or ceil), None keeps the exact distances
+enum class DistanceRounding : uint32_t {
+    None = 0,
+    Nearest = 1,
+    Floor = 2,
+    Ceil = 3,
+};
+
+/**
+ * Rounds the distance according to the rounding mode.
+ * @param distance the exact distance
+ * @param rounding the rounding mode
+ * @return the rounded distance
+ */
+double roundDistance(double distance, DistanceRounding rounding);
+
+enum class MatrixLayout : uint32_t {
+    Full = 0,
+    Triangular = 1, // lower triangle with the diagonal, row i holds the columns 0..i
+};
+
+class DistanceMatrix {
+public:
+    // View of one row of the matrix
+    class Row {
+    private:
+        const void* data;
+        size_t row;
+        size_t stride; // elements per row of a full matrix, 0 for the triangular layout
+        MatrixPrecision precision;
+    public:
+        Row(const void* data, size_t row, size_t stride, MatrixPrecision precision)
+            : data(data), row(row), stride(stride), precision(precision) {}
+
+        double operator[](size_t column) const {
+            size_t index = elementIndex(row, column, stride);
+            if (precision == MatrixPrecision::Double) {
+                return static_cast<const double*>(data)[index];
+            } else if (precision == MatrixPrecision::Float) {
+                return static_cast<const float*>(data)[index];
+            }
+            return static_cast<const int32_t*>(data)[index];
+        }
+    };
+
+    static size_t elementIndex(size_t row, size_t column, size_t stride) {
+        if (stride != 0) {
+            return row * stride + column;
+        }
+        return row >= column ? row * (row + 1) / 2 + column : column * (column + 1) / 2 + row;
+    }
+
+    /**
+     * Constructs an empty matrix.
+     */
+    DistanceMatrix();
+
+    /**
+     * Allocates a matrix of the given size filled with zeros.
+     * @param size number of nodes (rows and columns)
+     * @param precision type of the stored elements
+     * @param layout full matrix or the lower triangle of a symmetric matrix
+     */
+    DistanceMatrix(size_t size, MatrixPrecision precision = MatrixPrecision::Double,
+                   MatrixLayout layout = MatrixLayout::Full);
+
+    /**
+     * Calculates the euclidean distances between all nodes.
+     * For the distance matrix we assume that the IDs of the nodes are ordered from 1 to n
+     * @param nodes nodes of the problem, the depot first
+     * @param precision type of the stored elements
+     * @param rounding rounding of the distances, the integer precision rounds to the nearest integer by default
+     * @return the calculated matrix
+     */
+    static DistanceMatrix euclidean(const vector<Node>& nodes, MatrixPrecision precision = MatrixPrecision::Double,
+                                    DistanceRounding rounding = DistanceRounding::None);
+
+    /**
+     * Maps the matrix previously stored by save() into the memory (read-only, without copying it).
+     * @param path path to the file
+     * @param expectedHash hash the matrix was saved with, a mismatch means the file is stale
+     * @return the mapped matrix or an empty matrix if the file does not exist or does not match
+     */
+    static DistanceMatrix map(const string& path, uint64_t expectedHash);
+
+    /**
+     * Loads the explicit matrix from the file, the binary format is mapped and the TSPLIB format is parsed.
+     * @param path path to the file
+     * @param precision type of the elements of a parsed matrix (a mapped one keeps the stored precision)
+     * @param rounding rounding of the elements of a parsed matrix
+     * @return the loaded matrix
+     * @throws runtime_error if the file cannot be read or is not in a supported format
+     */
+    static DistanceMatrix load(const string& path, MatrixPrecision precision = MatrixPrecision::Double,
+                               DistanceRounding rounding = DistanceRounding::None);
+
+    /**
+     * Parses the matrix in the TSPLIB format (EDGE_WEIGHT_TYPE: EXPLICIT). The symmetric formats (all but
+     * FULL_MATRIX) are stored in the triangular layout.
+     * @param path path to the file
+     * @param precision type of the stored elements
+     * @param rounding rounding of the elements
+     * @return the parsed matrix
+     * @throws runtime_error if the file cannot be read or is not in a supported format
+     */
+    static DistanceMatrix parseTsplib(const string& path, MatrixPrecision precision = MatrixPrecision::Double,
+                                      DistanceRounding rounding = DistanceRounding::None);
+
+    /**
+     * Loads the matrix from the cache directory or calculates and stores it there if it is missing.
+     * The file is named by the hash of the coordinates, the metric and the precision.
+     * @param nodes nodes of the problem, the depot first
+     * @param precision type of the stored elements
+     * @param rounding rounding of the distances
+     * @param cacheDirectory directory of the cache, it is created if needed
+     * @return the mapped (or calculated if the cache cannot be written) matrix
+     */
+    static DistanceMatrix cached(const vector<Node>& nodes, MatrixPrecision precision, DistanceRounding rounding,
+                                 const string& cacheDirectory);
+
+    /**
+     * Stores the matrix into the file in the format that can be mapped by map().
+     * The file is written to a temporary name first and then renamed, so readers never see a partial file.
+     * @param path path to the file
+     * @param hash hash identifying the content of the matrix
+     * @throws runtime_error if the file cannot be written
+     */
+    void save(const string& path, uint64_t hash) const;
+
+    /**
+     * Retrieves the number of rows (and columns) of the matrix.
+     * @return number of nodes
+     */
+    size_t size() const;
+
+    /**
+     * Retrieves the type of the stored elements.
+     * @return precision of the matrix
+     */
+    MatrixPrecision precision() const;
+
+    /**
+     * Retrieves the way the elements are stored.
+     * @return layout of the matrix
+     */
+    MatrixLayout layout() const;
+
+    /**
+     * Checks whether the matrix is mapped from a file.
+     * @return true if the matrix is backed by a file
+     */
+    bool isMapped() const;
+
+    /**
+     * Retrieves the row of a full integer matrix for the integer kernels (e.g. fitness of the genetic algorithm).
+     * @param row index of the row
+     * @return pointer to the elements of the row, nullptr if the matrix is not a full integer matrix
+     */
+    const int32_t* integerRow(size_t row) const {
+        if (type != MatrixPrecision::Int32 or stride == 0) {
+            return nullptr;
+        }
+        return reinterpret_cast<const int32_t*>(data) + row * stride;
+    }
+
+    Row operator[](size_t row) const {
+        return Row(data, row, stride, type);
+    }
+
+    /**
+     * Sets the distance, possible only for an owned matrix that is not shared with any copy.
+     * The distance is rounded to the nearest integer if the matrix stores integers.
+     * @param row index of the first node
+     * @param column index of the second node
+     * @param distance the distance between the nodes
+     */
+    void set(size_t row, size_t column, double distance);
+
+    /**
+     * Copies the distances between the chosen nodes into a new (owned, full) matrix of the same precision,
+     * e.g. the depot and the customers assigned to it in a multi-depot problem.
+     * Time complexity: O(k^2) for k chosen nodes
+     * @param indices indices of the chosen nodes, the i-th one becomes the i-th node of the slice
+     * @return the slice
+     */
+    DistanceMatrix slice(const vector<int>& indices) const;
+
+private:
+    struct Storage;
+    shared_ptr<Storage> storage;
+    const unsigned char* data;
+    size_t nodes;
+    size_t stride;
+    MatrixPrecision type;
+
+    size_t elementCount() const;
+
+    static DistanceMatrix mapFile(const string& path, const uint64_t* expectedHash, string& error);
+};
+
+#endif //DISTANCEMATRIX_HPP
@@ -0,0 +1,452 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include "fleet.hpp"
+
+static const size_t MAX_LABELS = 4; // labels kept per position of the tour
+
+Fleet::Fleet() {
+}
+
+Fleet::Fleet(double capacity) {
+    types.push_back(VehicleType{0, capacity, -1});
+}
+
+Fleet Fleet::fromVehicles(const vector<Vehicle>& vehicles) {
+    Fleet fleet;
+    map<pair<double, int>, int> counts; // (capacity, type) -> number of vehicles, -1 if unlimited
+    for (auto& vehicle : vehicles) {
+        auto key = make_pair(vehicle.capacity, vehicle.type);
+        if (vehicle.number < 0 or (counts.count(key) and counts[key] < 0)) {
+            counts[key] = -1;
+        } else {
+            counts[key] += vehicle.number;
+        }
+    }
+    if (vehicles.empty()) {
+        throw invalid_argument("The problem has no vehicles");
+    }
+    for (auto& [key, count] : counts) {
+        fleet.types.push_back(VehicleType{key.second, key.first, count});
+    }
+    return fleet;
+}
+
+bool Fleet::isUniform() const {
+    return types.size() == 1 and types[0].count < 0;
+}
+
+double Fleet::maxCapacity() const {
+    return types.back().capacity;
+}
+
+int Fleet::largestAvailable(const vector<int>& used) const {
+    for (int t = types.size() - 1; t >= 0; t--) {
+        if (types[t].count < 0 or used[t] < types[t].count) {
+            return t;
+        }
+    }
+    return types.size() - 1;
+}
+
+int Fleet::smallestAvailable(double load, const vector<int>& used) const {
+    int fallback = -1;
+    for (int t = 0; t < (int)types.size(); t++) {
+        if (types[t].capacity < load) {
+            continue;
+        }
+        if (types[t].count < 0 or used[t] < types[t].count) {
+            return t;
+        }
+        if (fallback == -1) {
+            fallback = t;
+        }
+    }
+    return fallback;
+}
+
+double excessVehiclePenalty(const vector<int>& tour, const DistanceMatrix& distanceMatrix) {
+    double longestTrip = 0;
+    for (auto& customer : tour) {
+        longestTrip = max(longestTrip, distanceMatrix[0][customer-1] + distanceMatrix[customer-1][0]);
+    }
+    return 10 * (longestTrip + 1);
+}
+
+namespace {
+    struct Label {
+        double cost;        // distance plus the penalties of the excess vehicles and the time warp
+        double distance;
+        double timeWarp;
+        int excess;
+        int vehicles;
+        int position;       // number of customers served by the routes of the label
+        int predecessor;    // index of the label at the position where the last route starts
+        int type;           // vehicle type of the last route
+        size_t used;        // offset of the used counts of the limited types in the pool
+    };
+}
+
+FleetSplit splitFleet(const vector<int>& tour, const vector<Request>& requests, const Fleet& fleet,
+                      const DistanceMatrix& distanceMatrix, bool withRoutes) {
+    size_t n = tour.size();
+    size_t typesCount = fleet.types.size();
+    double penalty = excessVehiclePenalty(tour, distanceMatrix);
+    double maxCapacity = fleet.maxCapacity();
+
+    // Only the limited types are resources of the labels
+    vector<int> limitedIndex(typesCount, -1);
+    size_t limitedCount = 0;
+    int smallestUnlimited = -1;
+    for (size_t t = 0; t < typesCount; t++) {
+        if (fleet.types[t].count >= 0) {
+            limitedIndex[t] = limitedCount++;
+        }
+    }
+
+    // the buffers are reused by the following calls on the same thread, the split is called for every fitness
+    thread_local vector<Label> labels;
+    thread_local vector<int> usedPool;
+    thread_local vector<vector<int>> labelsAt; // indices of the labels ending at each position
+    labels.clear();
+    usedPool.assign(limitedCount, 0);
+    if (labelsAt.size() < n + 1) {
+        labelsAt.resize(n + 1);
+    }
+    for (size_t i = 0; i <= n; i++) {
+        labelsAt[i].clear();
+    }
+    labels.push_back(Label{0, 0, 0, 0, 0, 0, -1, -1, 0});
+    labelsAt[0].push_back(0);
+
+    auto dominates = [&](const Label& a, const Label& b) {
+        if (a.cost > b.cost or (fleet.maxVehicles >= 0 and a.vehicles > b.vehicles)) {
+            return false;
+        }
+        for (size_t r = 0; r < limitedCount; r++) {
+            if (usedPool[a.used + r] > usedPool[b.used + r]) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    vector<int> candidateUsed(limitedCount);
+    for (size_t i = 0; i < n; i++) {
+        if (labelsAt[i].empty()) {
+            continue;
+        }
+        double load = 0;
+        double inner = 0;
+        TimeWindowSegment segment; // customers from i to j
+        for (size_t j = i; j < n; j++) {
+            int customer = tour[j];
+            load += requests[customer-2].quantity; // customer with ID 2 has the request n. 0
+            if (load > maxCapacity) {
+                break;
+            }
+            if (j > i) {
+                inner += distanceMatrix[tour[j-1]-1][customer-1];
+            }
+            double routeDistance = distanceMatrix[0][tour[i]-1] + inner + distanceMatrix[customer-1][0];
+            double routeTimeWarp = 0;
+            if (fleet.timeWindows) {
+                auto next = TimeWindowSegment::customer(customer, requests);
+                segment = j > i ? segment.merge(next, distanceMatrix) : next;
+                auto depot = TimeWindowSegment::depot(fleet.horizon);
+                routeTimeWarp = depot.merge(segment, distanceMatrix).merge(depot, distanceMatrix).timeWarp;
+            }
+
+            // smallest unlimited type that fits, the larger unlimited types are never better
+            smallestUnlimited = -1;
+            for (size_t t = 0; t < typesCount; t++) {
+                if (fleet.types[t].count < 0 and fleet.types[t].capacity >= load) {
+                    smallestUnlimited = t;
+                    break;
+                }
+            }
+
+            for (int from : labelsAt[i]) {
+                for (size_t t = 0; t < typesCount; t++) {
+                    if (fleet.types[t].capacity < load) {
+                        continue;
+                    }
+                    if (fleet.types[t].count < 0 and (int)t != smallestUnlimited) {
+                        continue;
+                    }
+                    const Label& previous = labels[from];
+                    for (size_t r = 0; r < limitedCount; r++) {
+                        candidateUsed[r] = usedPool[previous.used + r];
+                    }
+                    int excess = previous.excess;
+                    if (limitedIndex[t] >= 0) {
+                        int& used = candidateUsed[limitedIndex[t]];
+                        if (used >= fleet.types[t].count) {
+                            excess++;
+                        }
+                        used++;
+                    }
+                    int overLimit = fleet.maxVehicles >= 0 ? max(0, previous.vehicles + 1 - fleet.maxVehicles) : 0;
+                    double timeWarp = previous.timeWarp + routeTimeWarp;
+                    Label candidate{previous.distance + routeDistance + (excess + overLimit) * penalty + timeWarp * TIME_WARP_PENALTY,
+                                    previous.distance + routeDistance, timeWarp, excess, previous.vehicles + 1, (int)j + 1, from, (int)t, usedPool.size()};
+                    usedPool.insert(usedPool.end(), candidateUsed.begin(), candidateUsed.end());
+
+                    // Keep the label only if it is not dominated, remove the labels it dominates
+                    auto& target = labelsAt[j + 1];
+                    bool dominated = false;
+                    for (int existing : target) {
+                        if (dominates(labels[existing], candidate)) {
+                            dominated = true;
+                            break;
+                        }
+                    }
+                    if (dominated) {
+                        usedPool.resize(candidate.used);
+                        continue;
+                    }
+                    target.erase(remove_if(target.begin(), target.end(),
+                                           [&](int existing) { return dominates(candidate, labels[existing]); }),
+                                 target.end());
+                    labels.push_back(candidate);
+                    target.push_back(labels.size() - 1);
+                    if (target.size() > MAX_LABELS) {
+                        // drop the most expensive label to keep the work per position bounded
+                        auto worst = max_element(target.begin(), target.end(),
+                                                 [&](int a, int b) { return labels[a].cost < labels[b].cost; });
+                        target.erase(worst);
+                    }
+                }
+            }
+        }
+    }
+
+    FleetSplit split;
+    if (labelsAt[n].empty()) {
+        throw invalid_argument("A request does not fit into any vehicle of the fleet");
+    }
+    int best = *min_element(labelsAt[n].begin(), labelsAt[n].end(),
+                            [&](int a, int b) { return labels[a].cost < labels[b].cost; });
+    split.distance = labels[best].distance;
+    split.vehicles = labels[best].vehicles;
+    split.timeWarp = labels[best].timeWarp;
+    split.excessVehicles = labels[best].excess;
+    if (fleet.maxVehicles >= 0) {
+        split.excessVehicles += max(0, split.vehicles - fleet.maxVehicles);
+    }
+
+    if (withRoutes) {
+        // Walk the predecessors back, every step is one route
+        for (int label = best; labels[label].predecessor != -1; label = labels[label].predecessor) {
+            int start = labels[labels[label].predecessor].position;
+            split.routes.push_back(vector<int>(tour.begin() + start, tour.begin() + labels[label].position));
+            split.types.push_back(labels[label].type);
+        }
+        reverse(split.routes.begin(), split.routes.end());
+        reverse(split.types.begin(), split.types.end());
+    }
+    return split;
+}
+
+FleetSplit splitRoutes(const vector<vector<int>>& routes, const vector<Request>& requests, const Fleet& fleet,
+                       const DistanceMatrix& distanceMatrix) {
+    vector<int> tour;
+    for (auto& route : routes) {
+        tour.insert(tour.end(), route.begin(), route.end());
+    }
+    return splitFleet(tour, requests, fleet, distanceMatrix, true);
+}
+
+// Distance of the route from the depot and back
+static double routeDistance(const vector<int>& route, const DistanceMatrix& distanceMatrix) {
+    double distance = 0;
+    int previous = 0;
+    for (auto& customer : route) {
+        distance += distanceMatrix[previous][customer-1];
+        previous = customer - 1;
+    }
+    return distance + distanceMatrix[previous][0];
+}
+
+void assignVehicles(Solution& solution, const vector<vector<int>>& routes, const vector<Request>& requests,
+                    const Fleet& fleet, const DistanceMatrix& distanceMatrix) {
+    solution.distance = 0;
+    solution.capacities.clear();
+    if (fleet.isUniform()) {
+        solution.routes = routes;
+        for (auto& route : routes) {
+            solution.distance += routeDistance(route, distanceMatrix);
+        }
+        return;
+    }
+    // the routes were built for the largest vehicle, the vehicles are assigned within the available counts
+    FleetSplit split = splitRoutes(routes, requests, fleet, distanceMatrix);
+    solution.routes = split.routes;
+    solution.distance = split.distance;
+    for (auto& type : split.types) {
+        solution.capacities.push_back(fleet.types[type].capacity);
+    }
+}
+
+int vehicleLowerBound(const vector<Request>& requests, double capacity) {
+    vector<double> demands;
+    for (auto& request : requests) {
+        demands.push_back(request.quantity);
+    }
+    sort(demands.begin(), demands.end());
+    size_t n = demands.size();
+    vector<double> prefix(n + 1, 0); // prefix[i] is the sum of the i smallest demands
+    for (size_t i = 0; i < n; i++) {
+        prefix[i+1] = prefix[i] + demands[i];
+    }
+    auto sum = [&](size_t from, size_t to) { return prefix[to] - prefix[from]; };
+
+    // L1, the total demand over the capacity (the small epsilon absorbs the rounding of the sums)
+    int bound = ceil(prefix[n] / capacity - 1e-9);
+
+    // L2, for every threshold alpha the demands larger than C/2 need a vehicle each and the demands between
+    // alpha and C/2 can only use the space those vehicles leave (or more vehicles)
+    size_t half = upper_bound(demands.begin(), demands.end(), capacity / 2) - demands.begin();
+    for (size_t a = 0; a <= half; a++) {
+        double alpha = a < half ? demands[a] : 0;
+        if (a > 0 and a < half and demands[a] == demands[a-1]) {
+            continue;
+        }
+        size_t large = upper_bound(demands.begin(), demands.end(), capacity - alpha) - demands.begin();
+        size_t small = lower_bound(demands.begin(), demands.end(), alpha) - demands.begin();
+        int vehicles = (n - large) + (large - half); // J1 and J2, every one needs its own vehicle
+        double spaceLeft = (large - half) * capacity - sum(half, large);
+        double remaining = sum(small, half) - spaceLeft;
+        if (remaining > 0) {
+            vehicles += ceil(remaining / capacity - 1e-9);
+        }
+        bound = max(bound, vehicles);
+    }
+    return bound;
+}
+
+static double routeLoad(const vector<int>& route, const vector<Request>& requests) {
+    double load = 0;
+    for (auto& customer : route) {
+        load += requests[customer-2].quantity; // customer with ID 2 has the request n. 0
+    }
+    return load;
+}
+
+// Inserts the customer where it extends the route the least
+static void cheapestInsertion(vector<int>& route, int customer, const DistanceMatrix& distanceMatrix) {
+    size_t bestPosition = 0;
+    double bestIncrease = 0;
+    for (size_t position = 0; position <= route.size(); position++) {
+        int before = position == 0 ? 0 : route[position-1] - 1;
+        int after = position == route.size() ? 0 : route[position] - 1;
+        double increase = distanceMatrix[before][customer-1] + distanceMatrix[customer-1][after] - distanceMatrix[before][after];
+        if (position == 0 or increase < bestIncrease) {
+            bestIncrease = increase;
+            bestPosition = position;
+        }
+    }
+    route.insert(route.begin() + bestPosition, customer);
+}
+
+void repairFleetSize(vector<vector<int>>& routes, vector<double>& capacities, const vector<Request>& requests,
+                     const Fleet& fleet, const DistanceMatrix& distanceMatrix) {
+    if (fleet.maxVehicles < 0 or (int)routes.size() <= fleet.maxVehicles) {
+        return;
+    }
+    size_t limit = fleet.maxVehicles;
+    bool ownCapacities = !capacities.empty();
+    if (!ownCapacities) {
+        capacities.assign(routes.size(), fleet.maxCapacity());
+    }
+    vector<double> loads;
+    for (auto& route : routes) {
+        loads.push_back(routeLoad(route, requests));
+    }
+
+    // The lightest routes are dissolved, their vehicles are no longer needed
+    vector<size_t> order(routes.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](size_t a, size_t b) { return loads[a] > loads[b]; });
+    vector<int> moved;
+    for (size_t i = limit; i < order.size(); i++) {
+        moved.insert(moved.end(), routes[order[i]].begin(), routes[order[i]].end());
+    }
+    // The largest demands are placed first, always into the route with the most space left
+    sort(moved.begin(), moved.end(), [&](int a, int b) { return requests[a-2].quantity > requests[b-2].quantity; });
+    priority_queue<pair<double, size_t>> space; // (capacity left, route)
+    for (size_t i = 0; i < limit; i++) {
+        space.push(make_pair(capacities[order[i]] - loads[order[i]], order[i]));
+    }
+    vector<vector<int>> repaired = routes;
+    bool fits = true;
+    for (auto& customer : moved) {
+        auto [left, route] = space.top();
+        double demand = requests[customer-2].quantity;
+        if (left < demand) {
+            fits = false;
+            break;
+        }
+        space.pop();
+        cheapestInsertion(repaired[route], customer, distanceMatrix);
+        space.push(make_pair(left - demand, route));
+    }
+
+    if (!fits) {
+        // Repack all customers with the first fit decreasing into the largest kept vehicles, the customers
+        // are then visited in the order of the original routes
+        vector<double> kept;
+        for (size_t i = 0; i < limit; i++) {
+            kept.push_back(capacities[order[i]]);
+        }
+        sort(kept.begin(), kept.end(), greater<double>());
+        vector<int> customers;
+        vector<size_t> visitOrder(requests.size() + 2);
+        for (auto& route : routes) {
+            for (auto& customer : route) {
+                visitOrder[customer] = customers.size();
+                customers.push_back(customer);
+            }
+        }
+        sort(customers.begin(), customers.end(), [&](int a, int b) { return requests[a-2].quantity > requests[b-2].quantity; });
+        repaired.assign(limit, vector<int>());
+        vector<double> left = kept;
+        for (auto& customer : customers) {
+            double demand = requests[customer-2].quantity;
+            size_t bin = 0;
+            while (bin < limit and left[bin] < demand) {
+                bin++;
+            }
+            if (bin == limit) {
+                throw runtime_error("The customers could not be served by " + to_string(limit) + " vehicles");
+            }
+            left[bin] -= demand;
+            repaired[bin].push_back(customer);
+        }
+        routes.clear();
+        capacities.clear();
+        for (size_t bin = 0; bin < limit; bin++) {
+            // a vehicle left without customers stays at the depot, it is not a route
+            if (repaired[bin].empty()) {
+                continue;
+            }
+            sort(repaired[bin].begin(), repaired[bin].end(), [&](int a, int b) { return visitOrder[a] < visitOrder[b]; });
+            routes.push_back(repaired[bin]);
+            capacities.push_back(kept[bin]);
+        }
+    } else {
+        routes.clear();
+        vector<double> keptCapacities;
+        for (size_t i = 0; i < limit; i++) {
+            routes.push_back(repaired[order[i]]);
+            keptCapacities.push_back(capacities[order[i]]);
+        }
+        capacities = keptCapacities;
+    }
+    if (!ownCapacities) {
+        capacities.clear();
+    }
+}
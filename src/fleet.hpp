@@ -0,0 +1,175 @@
+/**
+ * Fleet of vehicles available to the algorithms
+ * The algorithms originally used only the capacity of the first vehicle profile and an unlimited number of
+ * vehicles (uniform fleet). The heterogeneous fleet groups all vehicle profiles of the instance into types
+ * with their capacities and counts, the routes are then served by the smallest available vehicle that fits.
+**/
+
+#ifndef FLEET_HPP
+#define FLEET_HPP
+
+#include <vector>
+#include "../structures/Request.hpp"
+#include "../structures/Solution.hpp"
+#include "../structures/Vehicle.hpp"
+#include "distancematrix.hpp"
+#include "timewindows.hpp"
+
+using namespace std;
+
+struct VehicleType {
+    int type;           // type of the vehicle profile in the instance
+    double capacity;    // how much the vehicle can carry
+    int count;          // number of available vehicles, -1 if unlimited
+};
+
+class Fleet {
+public:
+    vector<VehicleType> types; // sorted by the capacity, the smallest first
+    int maxVehicles = -1;      // limit on the number of vehicles (routes) overall, -1 if unlimited
+    bool timeWindows = false;  // whether the time windows of the requests have to be met
+    double horizon = numeric_limits<double>::infinity(); // the latest return of the vehicles to the depot
+
+    Fleet();
+
+    /**
+     * Constructs the uniform fleet, an unlimited number of vehicles with the same capacity.
+     * Intentionally not explicit, so the functions taking a fleet can still be called with the capacity.
+     * @param capacity capacity of all the vehicles
+     */
+    Fleet(double capacity);
+
+    /**
+     * Groups the vehicle profiles of the instance into vehicle types. Profiles with the same type and capacity
+     * form one type, the count is the sum of their numbers. A profile with no number means an unlimited
+     * number of such vehicles (the convention of the single-profile instances).
+     * @param vehicles vehicle profiles of the instance
+     * @return the heterogeneous fleet
+     */
+    static Fleet fromVehicles(const vector<Vehicle>& vehicles);
+
+    /**
+     * Checks whether the fleet is a single vehicle type without a limit, so the fast splitting can be used.
+     * @return true if the fleet is uniform
+     */
+    bool isUniform() const;
+
+    /**
+     * Retrieves the capacity of the largest vehicle.
+     * @return the largest capacity in the fleet
+     */
+    double maxCapacity() const;
+
+    /**
+     * Finds the largest vehicle type that is still available.
+     * @param used number of vehicles of each type already used
+     * @return index of the type, the largest type overall if none is available
+     */
+    int largestAvailable(const vector<int>& used) const;
+
+    /**
+     * Finds the smallest available vehicle type that can carry the load.
+     * @param load the load of the route
+     * @param used number of vehicles of each type already used
+     * @return index of the type, the smallest type that fits (even if exhausted) if none is available, -1 if the
+     *         load does not fit into any vehicle
+     */
+    int smallestAvailable(double load, const vector<int>& used) const;
+};
+
+// Result of splitting the giant tour into routes served by the vehicles of the fleet
+struct FleetSplit {
+    double distance = 0;            // distance of all routes
+    int vehicles = 0;               // number of routes
+    double timeWarp = 0;            // time warp of all routes (0 if the time windows are met)
+    int excessVehicles = 0;         // vehicles used over the available counts or the limit (0 for a feasible split)
+    vector<vector<int>> routes;     // the routes (only if requested)
+    vector<int> types;              // index of the vehicle type serving each route (only if requested)
+};
+
+/**
+ * Splits the giant tour (customer IDs without the depot) into routes with the fleet-aware Split.
+ * It is a dynamic programming over the positions in the tour, where each label carries the number of used
+ * vehicles of every limited type (bounded resources). With time windows, the time warp of each candidate route
+ * is penalized, it is known in O(1) as the segment of the route is extended customer by customer. Dominated
+ * labels are pruned and only a few labels are kept per position, and a route never exceeds the largest capacity,
+ * so in practice the cost stays close to linear.
+ * Using more vehicles of a type than available is allowed with a large penalty, so a split always exists.
+ * Time complexity: O(n * B * L * T) where B is the maximal number of customers on a route, L the number of labels
+ *                  per position and T the number of vehicle types
+ * Space complexity: O(n * L * T)
+ * @param tour the giant tour
+ * @param requests requests of the customers, customer with ID i has the request i-2
+ * @param fleet the available vehicles
+ * @param distanceMatrix distances between all nodes
+ * @param withRoutes if true, the routes and their vehicle types are reconstructed
+ * @return the split
+ */
+FleetSplit splitFleet(const vector<int>& tour, const vector<Request>& requests, const Fleet& fleet,
+                      const DistanceMatrix& distanceMatrix, bool withRoutes);
+
+/**
+ * Assigns the vehicles of the fleet to the routes built for its largest vehicle (by the search engines), the
+ * concatenation of the routes is split again with splitFleet(), so the available counts are respected.
+ * @param routes the routes (customer IDs without the depot)
+ * @param requests requests of the customers, customer with ID i has the request i-2
+ * @param fleet the available vehicles
+ * @param distanceMatrix distances between all nodes
+ * @return the split with the routes and their vehicle types
+ */
+FleetSplit splitRoutes(const vector<vector<int>>& routes, const vector<Request>& requests, const Fleet& fleet,
+                       const DistanceMatrix& distanceMatrix);
+
+/**
+ * Fills the routes of the solution of a search engine in, with their distance and the capacities of the vehicles.
+ * A uniform fleet takes the routes as they are, otherwise the vehicles are assigned with splitRoutes().
+ * Time complexity: O(n), or the complexity of splitFleet() for a heterogeneous fleet
+ * @param solution the solution to be filled in
+ * @param routes the routes built for the largest vehicle (customer IDs without the depot)
+ * @param requests requests of the customers, customer with ID i has the request i-2
+ * @param fleet the available vehicles
+ * @param distanceMatrix distances between all nodes
+ */
+void assignVehicles(Solution& solution, const vector<vector<int>>& routes, const vector<Request>& requests,
+                    const Fleet& fleet, const DistanceMatrix& distanceMatrix);
+
+/**
+ * Calculates the penalty of one vehicle used over the available count, it is larger than any route.
+ * @param tour customers of the problem
+ * @param distanceMatrix distances between all nodes
+ * @return the penalty
+ */
+double excessVehiclePenalty(const vector<int>& tour, const DistanceMatrix& distanceMatrix);
+
+/**
+ * Calculates a lower bound of the number of vehicles needed to serve the requests, the bin packing bound L2
+ * of Martello and Toth (which is at least the total demand over the capacity). It is used to reject a limit
+ * on the number of vehicles that cannot be met before any algorithm runs.
+ * Time complexity: O(n log n)
+ * Space complexity: O(n)
+ * @param requests requests of the customers
+ * @param capacity capacity of the vehicles (the largest one for a heterogeneous fleet)
+ * @return the lower bound
+ */
+int vehicleLowerBound(const vector<Request>& requests, double capacity);
+
+/**
+ * Repairs the routes to need no more vehicles than the limit of the fleet. The lightest routes are dissolved and
+ * their customers are reinserted (largest demand first) into the route with the most capacity left, at the
+ * cheapest position. If that fails, all customers are repacked with the first fit decreasing, and if even that
+ * fails, no solution within the limit was found. The vehicles left without customers by the repacking are
+ * dropped, so fewer routes than the limit may be returned.
+ * Time complexity: O(n log n) to choose the routes plus O(m * R) for the insertions, where m is the number of moved
+ *                  customers and R the length of a route (O(n * k) for the repacking)
+ * Space complexity: O(n)
+ * @param routes the routes to be repaired (customer IDs without the depot)
+ * @param capacities capacity of the vehicle of each route, empty if all have the largest capacity of the fleet
+ * @param requests requests of the customers, customer with ID i has the request i-2
+ * @param fleet the available vehicles with the limit
+ * @param distanceMatrix distances between all nodes
+ * @throws runtime_error if the customers cannot be packed into the limited number of vehicles
+ */
+void repairFleetSize(vector<vector<int>>& routes, vector<double>& capacities, const vector<Request>& requests,
+                     const Fleet& fleet, const DistanceMatrix& distanceMatrix);
+
+#endif //FLEET_HPP
@@ -1,51 +1,247 @@
-
 #include <cstring>
 #include <filesystem>
-#include "genetic.hpp"
-#include "savings.hpp"
+#include <stdexcept>
+#include "batch.hpp"
+#include "decomposition.hpp"
+#include "server.hpp"
+#include "warmstart.hpp"
 
 using namespace std;
 
+static bool isOutputFormat(const char* name) {
+    return strcmp(name, "text") == 0 or strcmp(name, "json") == 0 or strcmp(name, "csv") == 0;
+}
+
 int main(int argc, char* argv[]) {
 
+    SolverOptions options;
     string algo;
     string data;
+    string output;
+    string initialSolution;
+    size_t jobs = 0;
     string usage = ("gal <option> <data-path>\n"
+                    "gal batch <dir-or-list> [<option>]\n"
+                    "gal serve <socket-path> [--jobs N]\n"
+                    "gal convert-matrix <tsplib-file> <output.dm> [--matrix-precision <type>]\n"
                     "\t<option>: One of the available options (with argument if needed)\n"
                     "\t  --help (-h) show this help message.\n"
-                    "\t  --algorithm (-a) specified an algorithm as argument ['savings'|'genetic']\n"
-                    "\t<data-path>: Path to the file with the representation of the CVRP problem.\n");
+                    "\t  --algorithm (-a) specified an algorithm as argument ['savings'|'genetic'|'lns'|'tabu'|'sweep'|'portfolio']\n"
+                    "\t  --output (-o) format of the result ['text'|'json'|'csv'] (default: text, csv in batch mode)\n"
+                    "\t  --distance-matrix <file> explicit distance matrix (binary .dm or TSPLIB EXPLICIT) used instead\n"
+                    "\t                           of the euclidean distances, the binary format is memory-mapped\n"
+                    "\t  --matrix-cache <dir> store distance matrices in the directory and map them on later runs\n"
+                    "\t  --matrix-precision ['double'|'float'] type of the distance matrix elements (default: double)\n"
+                    "\t  --round ['nint'|'floor'|'ceil'] round the distances to integers (stored as 32-bit integers),\n"
+                    "\t                                 nint is the rounding used by the published CVRPLIB results\n"
+                    "\t  --fleet ['uniform'|'heterogeneous'] vehicles used by the algorithms, uniform is an unlimited number\n"
+                    "\t                                     of vehicles with the first capacity, heterogeneous uses all vehicle\n"
+                    "\t                                     profiles with their numbers (default: uniform)\n"
+                    "\t  --time-limit <seconds> how long the lns, tabu and portfolio algorithms search (default: a fixed number\n"
+                    "\t                        of iterations)\n"
+                    "\t  --max-vehicles <k|'auto'> at most k vehicles may be used, auto takes k from the instance name (-kNN)\n"
+                    "\t  --decompose ['sectors'|'kmeans'] split the customers into angular sectors or k-means clusters\n"
+                    "\t                                  solved separately in parallel (for very large instances)\n"
+                    "\t  --cluster-size <n> the largest number of customers of a cluster (default: 200)\n"
+                    "\t  --reoptimize-boundaries solve the routes along the borders of the clusters again\n"
+                    "\t  --initial-solution <file> start the genetic, lns, tabu or portfolio algorithm from the routes\n"
+                    "\t                            of a previous solution (any output format), the customers missing\n"
+                    "\t                            from it are inserted at the cheapest position\n"
+                    "\t  --optimize-routes reorder the customers of every final route (exactly up to 12 customers)\n"
+                    "\t  --seed <n> seed of the random numbers, the same seed gives the same solution regardless of\n"
+                    "\t             the number of threads unless --time-limit is given (default: 0)\n"
+                    "\t  --generational genetic breeds generations of 32 offspring in parallel (--jobs threads),\n"
+                    "\t                 the result is the same for any number of threads\n"
+                    "\t  --jobs (-j) number of worker threads in batch and serve mode, solving the clusters\n"
+                    "\t              of the decomposition, the sweeps from different angles or the initial\n"
+                    "\t              solutions of genetic (default: one per hardware thread, sweep uses only\n"
+                    "\t              the calling thread)\n"
+                    "\t<data-path>: Path to the file with the representation of the CVRP problem.\n"
+                    "\tbatch: Solve all instances in the directory (or listed in the file, one path per line)\n"
+                    "\t       in parallel and print one record per instance.\n"
+                    "\tserve: Solve requests sent over the Unix domain socket until interrupted, see src/server.hpp\n"
+                    "\t       for the protocol and serve-client.py for an example client.\n"
+                    "\tconvert-matrix: Convert the TSPLIB matrix into the binary format that can be memory-mapped.\n");
     if (argc < 2 or strcmp(argv[1], "--help") == 0 or strcmp(argv[1], "-h") == 0) {
         cout << usage << endl;
         exit(EXIT_SUCCESS);
-    } else if (strcmp(argv[1], "--algorithm") == 0 or strcmp(argv[1], "-a") == 0) {
-        if (argc < 3 or (strcmp(argv[2], "savings") == 0 and strcmp(argv[2], "genetic") == 0)) {
-            cerr << "--algorithm requires an argument ['savings'|'genetic']\n";
+    }
+
+    bool batch = strcmp(argv[1], "batch") == 0;
+    bool server = strcmp(argv[1], "serve") == 0;
+    bool convert = strcmp(argv[1], "convert-matrix") == 0;
+    string convertOutput;
+    for (int i = batch or server or convert ? 2 : 1; i < argc; i++) {
+        if (strcmp(argv[i], "--algorithm") == 0 or strcmp(argv[i], "-a") == 0) {
+            if (i + 1 >= argc or !Solver::isAlgorithm(argv[i+1])) {
+                cerr << "--algorithm requires an argument ['savings'|'genetic'|'lns'|'tabu'|'sweep'|'portfolio']\n";
+                exit(EXIT_FAILURE);
+            }
+            algo = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 or strcmp(argv[i], "-o") == 0) {
+            if (i + 1 >= argc or !isOutputFormat(argv[i+1])) {
+                cerr << "--output requires an argument ['text'|'json'|'csv']\n";
+                exit(EXIT_FAILURE);
+            }
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--distance-matrix") == 0) {
+            if (i + 1 >= argc) {
+                cerr << "--distance-matrix requires a path to the file\n";
+                exit(EXIT_FAILURE);
+            }
+            options.distanceMatrix = argv[++i];
+        } else if (strcmp(argv[i], "--matrix-cache") == 0) {
+            if (i + 1 >= argc) {
+                cerr << "--matrix-cache requires a path to the directory\n";
+                exit(EXIT_FAILURE);
+            }
+            options.matrixCache = argv[++i];
+        } else if (strcmp(argv[i], "--matrix-precision") == 0) {
+            if (i + 1 >= argc or (strcmp(argv[i+1], "double") != 0 and strcmp(argv[i+1], "float") != 0)) {
+                cerr << "--matrix-precision requires an argument ['double'|'float']\n";
+                exit(EXIT_FAILURE);
+            }
+            options.matrixPrecision = strcmp(argv[++i], "float") == 0 ? MatrixPrecision::Float : MatrixPrecision::Double;
+        } else if (strcmp(argv[i], "--round") == 0) {
+            if (i + 1 < argc and strcmp(argv[i+1], "nint") == 0) {
+                options.rounding = DistanceRounding::Nearest;
+            } else if (i + 1 < argc and strcmp(argv[i+1], "floor") == 0) {
+                options.rounding = DistanceRounding::Floor;
+            } else if (i + 1 < argc and strcmp(argv[i+1], "ceil") == 0) {
+                options.rounding = DistanceRounding::Ceil;
+            } else {
+                cerr << "--round requires an argument ['nint'|'floor'|'ceil']\n";
+                exit(EXIT_FAILURE);
+            }
+            i++;
+        } else if (strcmp(argv[i], "--fleet") == 0) {
+            if (i + 1 >= argc or (strcmp(argv[i+1], "uniform") != 0 and strcmp(argv[i+1], "heterogeneous") != 0)) {
+                cerr << "--fleet requires an argument ['uniform'|'heterogeneous']\n";
+                exit(EXIT_FAILURE);
+            }
+            options.heterogeneousFleet = strcmp(argv[++i], "heterogeneous") == 0;
+        } else if (strcmp(argv[i], "--time-limit") == 0) {
+            if (i + 1 >= argc or atof(argv[i+1]) <= 0) {
+                cerr << "--time-limit requires a positive number of seconds\n";
+                exit(EXIT_FAILURE);
+            }
+            options.timeLimit = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-vehicles") == 0) {
+            if (i + 1 < argc and strcmp(argv[i+1], "auto") == 0) {
+                options.maxVehicles = -1;
+            } else if (i + 1 < argc and atoi(argv[i+1]) > 0) {
+                options.maxVehicles = atoi(argv[i+1]);
+            } else {
+                cerr << "--max-vehicles requires a positive number of vehicles or 'auto'\n";
+                exit(EXIT_FAILURE);
+            }
+            i++;
+        } else if (strcmp(argv[i], "--decompose") == 0) {
+            if (i + 1 >= argc or !isDecomposition(argv[i+1])) {
+                cerr << "--decompose requires an argument ['sectors'|'kmeans']\n";
+                exit(EXIT_FAILURE);
+            }
+            options.decomposition = argv[++i];
+        } else if (strcmp(argv[i], "--cluster-size") == 0) {
+            if (i + 1 >= argc or atoi(argv[i+1]) <= 0) {
+                cerr << "--cluster-size requires a positive number of customers\n";
+                exit(EXIT_FAILURE);
+            }
+            options.clusterSize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--reoptimize-boundaries") == 0) {
+            options.boundaryReoptimization = true;
+        } else if (strcmp(argv[i], "--initial-solution") == 0) {
+            if (i + 1 >= argc) {
+                cerr << "--initial-solution requires a path to the solution\n";
+                exit(EXIT_FAILURE);
+            }
+            initialSolution = argv[++i];
+        } else if (strcmp(argv[i], "--optimize-routes") == 0) {
+            options.optimizeRoutes = true;
+        } else if (strcmp(argv[i], "--generational") == 0) {
+            options.generational = true;
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            if (i + 1 >= argc or argv[i+1][0] == '\0' or strspn(argv[i+1], "0123456789") != strlen(argv[i+1])) {
+                cerr << "--seed requires a non-negative integer\n";
+                exit(EXIT_FAILURE);
+            }
+            options.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--jobs") == 0 or strcmp(argv[i], "-j") == 0) {
+            if (i + 1 >= argc or atoi(argv[i+1]) <= 0) {
+                cerr << "--jobs requires a positive number of threads\n";
+                exit(EXIT_FAILURE);
+            }
+            jobs = atoi(argv[++i]);
+        } else if (data.empty() and argv[i][0] != '-') {
+            data = argv[i];
+        } else if (convert and convertOutput.empty() and argv[i][0] != '-') {
+            convertOutput = argv[i];
+        } else {
+            cout << usage << endl;
             exit(EXIT_FAILURE);
         }
-        algo = argv[2];
-        if (argc < 4) {
-            cerr << "last argument should be a path to data file.\n";
+    }
+
+    if (data.empty()) {
+        cerr << (batch ? "batch requires a directory or a list of instances.\n"
+                 : server ? "serve requires a path to the socket.\n"
+                 : "last argument should be a path to data file.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (convert) {
+        if (convertOutput.empty()) {
+            cerr << "convert-matrix requires a path to the output file.\n";
             exit(EXIT_FAILURE);
         }
-        data = argv[3];
-    } else {
-        cout << usage << endl;
+        try {
+            auto precision = options.rounding != DistanceRounding::None ? MatrixPrecision::Int32 : options.matrixPrecision;
+            DistanceMatrix::parseTsplib(data, precision, options.rounding).save(convertOutput, 0);
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            exit(EXIT_FAILURE);
+        }
+        return EXIT_SUCCESS;
+    }
+    if ((batch or server) and !initialSolution.empty()) {
+        cerr << "--initial-solution is supported only for a single instance\n";
         exit(EXIT_FAILURE);
     }
+    if (server) {
+        return serve(data, jobs, options); // the algorithm and the output format are chosen by each request
+    }
+
+    try {
+        if (batch) {
+            if (algo.empty()) {
+                algo = "genetic";
+            }
+            if (output.empty() or output == "text") {
+                output = "csv"; // the text output is not suited for multiple instances
+            }
+            options.algorithm = algo;
+            options.threads = 1; // the instances are already solved in parallel, their clusters are not
+            vector<string> instances = collectInstances(data);
+            return runBatch(instances, options, jobs, output) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
 
-    // Load data
-    VRPDataReader reader = VRPDataReader(data);
-
-    vector<Node> nodes = reader.nodes;          // the 0th node is the depot
-    vector<Request> requests = reader.requests; // each customer has single request
-    vector<Vehicle> vehicles = reader.vehicles; // the number of vehicles is not taken into
-                                                // account only the capacity which is taken from the first vehicle
-    double vehicleCapacity = vehicles[0].capacity;
-    if (algo == "savings") {
-        savingsAlgorithm(nodes, requests, vehicleCapacity);
-    } else if (algo == "genetic") {
-        genetic(nodes, requests, vehicleCapacity);
+        if (algo.empty()) {
+            cerr << "--algorithm requires an argument ['savings'|'genetic'|'lns'|'tabu'|'sweep'|'portfolio']\n";
+            exit(EXIT_FAILURE);
+        }
+        // Load data and run the algorithm
+        if (!initialSolution.empty()) {
+            options.initialRoutes = readSolutionRoutes(initialSolution);
+        }
+        options.algorithm = algo;
+        options.threads = jobs;
+        Solution solution = Solver::solveFile(data, options);
+        if (output == "csv") {
+            cout << Solution::csvHeader() << endl;
+        }
+        printSolution(solution, output.empty() ? "text" : output);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        exit(EXIT_FAILURE);
     }
     return 0;
 }
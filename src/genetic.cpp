@@ -4,52 +4,469 @@
  * Partially inspired by https://github.com/krishna-praveen/Capacitated-Vehicle-Routing-Problem
 **/
 
+#include <array>
+#include <exception>
+#include <functional>
+#include <numeric>
+#include <optional>
 #include "genetic.hpp"
+#include "random.hpp"
+#include "savings.hpp"
+#include "sweep.hpp"
+#include "threadpool.hpp"
 #include "util.hpp"
+#include "timing.hpp"
 
 using namespace std;
 
 /**
- * Function to initialize the population randomly
- * Time complexity: O(n + populationSize * (n + n)) = ~O(p*2n)
- * Space complexity: O(n + populationSize * n) = ~O(p*n)
+ * Function to get a random number, a replacement for rand()
+ * rand() shares a single locked state between all threads, which serializes the runs in the batch mode,
+ * so every thread gets its own generator seeded by the solve instead (see random.hpp)
 */
-vector<vector<int>> initPopulation(const vector<Node> &customers, const size_t &populationSize) {
+static unsigned int randomNumber() {
+    return threadRandom()() >> 32;
+}
 
-    vector<vector<int>> population;
-    vector<int> customer_ids;
-    size_t n_of_customers = customers.size();
+/**
+ * Function to get the Zobrist key of the customer at the position of the chromosome (splitmix64 of both)
+ * Time complexity: O(1)
+ * Space complexity: O(1)
+*/
+static uint64_t zobristKey(size_t position, int customer) {
+    uint64_t key = ((uint64_t)position << 32 | (uint32_t)customer) + 0x9E3779B97F4A7C15ULL;
+    key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+    return key ^ (key >> 31);
+}
 
-    for (size_t i = 1; i < n_of_customers; i++) { // Start from 1 because the depot is not a customer (and it's always the first one)
-        customer_ids.push_back(customers[i].id);
+/**
+ * Function to get the Zobrist hash of the chromosome, the keys of its (position, customer) pairs xored together,
+ * the operators return whole new tours, so the hash of every offspring is computed once from scratch
+ * Time complexity: O(n)
+ * Space complexity: O(1)
+*/
+static uint64_t chromosomeHash(const vector<int> &solution) {
+    uint64_t hash = 0;
+    for (size_t i = 0; i < solution.size(); i++) {
+        hash ^= zobristKey(i, solution[i]);
+    }
+    return hash;
+}
+
+// Number of mutations of an offspring identical to a member before it is rejected
+static constexpr int CLONE_MUTATIONS = 3;
+
+namespace {
+    /**
+     * Hashes of the chromosomes of the population with the number of members having them (the population may hold
+     * the same chromosome twice, e.g. after the incumbent of another engine joined it) in a flat open addressing
+     * table (linear probing, the removed entries are not left behind as tombstones, the following entries of the
+     * cluster are moved back instead)
+     */
+    class ChromosomeSet {
+    private:
+        static constexpr uint64_t EMPTY = ~0ULL;
+        vector<uint64_t> keys;
+        vector<uint32_t> counts; // members with the key of the same slot
+        size_t used = 0;
+        int bits = 7;
+
+        static uint64_t key(uint64_t hash) {
+            return hash == EMPTY ? EMPTY - 1 : hash;
+        }
+
+        size_t find(uint64_t key) const {
+            size_t mask = keys.size() - 1;
+            size_t slot = (key * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+            while (keys[slot] != EMPTY and keys[slot] != key) {
+                slot = (slot + 1) & mask;
+            }
+            return slot;
+        }
+
+        void grow() {
+            vector<uint64_t> oldKeys = move(keys);
+            vector<uint32_t> oldCounts = move(counts);
+            bits++;
+            keys.assign((size_t)1 << bits, EMPTY);
+            counts.assign(keys.size(), 0);
+            for (size_t old = 0; old < oldKeys.size(); old++) {
+                if (oldKeys[old] != EMPTY) {
+                    size_t slot = find(oldKeys[old]);
+                    keys[slot] = oldKeys[old];
+                    counts[slot] = oldCounts[old];
+                }
+            }
+        }
+
+    public:
+        ChromosomeSet() : keys((size_t)1 << 7, EMPTY), counts(keys.size(), 0) {}
+
+        bool contains(uint64_t hash) const {
+            return keys[find(key(hash))] != EMPTY;
+        }
+
+        // Adds a member with the hash, returns false if another member already has it
+        bool insert(uint64_t hash) {
+            size_t slot = find(key(hash));
+            if (keys[slot] != EMPTY) {
+                counts[slot]++;
+                return false;
+            }
+            keys[slot] = key(hash);
+            counts[slot] = 1;
+            if (++used * 2 > keys.size()) {
+                grow();
+            }
+            return true;
+        }
+
+        // Removes a member with the hash, the hash stays while other members have it
+        void erase(uint64_t hash) {
+            size_t slot = find(key(hash));
+            if (keys[slot] == EMPTY or --counts[slot] > 0) {
+                return;
+            }
+            keys[slot] = EMPTY;
+            used--;
+            size_t mask = keys.size() - 1;
+            for (size_t next = (slot + 1) & mask; keys[next] != EMPTY; next = (next + 1) & mask) {
+                uint64_t moved = keys[next];
+                uint32_t count = counts[next];
+                keys[next] = EMPTY;
+                counts[next] = 0;
+                size_t to = find(moved);
+                keys[to] = moved;
+                counts[to] = count;
+            }
+        }
+
+        void assign(const vector<vector<int>> &population) {
+            keys.assign(keys.size(), EMPTY);
+            counts.assign(keys.size(), 0);
+            used = 0;
+            for (auto &member : population) {
+                insert(chromosomeHash(member));
+            }
+        }
+    };
+}
+
+namespace {
+    // Successor and predecessor of every customer (by ID) in a giant tour, 1 for the depot, 0 if absent
+    struct Adjacency {
+        vector<int> next;
+        vector<int> previous;
+
+        Adjacency(const vector<int> &tour, size_t ids) : next(ids, 0), previous(ids, 0) {
+            for (size_t i = 0; i < tour.size(); i++) {
+                previous[tour[i]] = i == 0 ? 1 : tour[i-1];
+                next[tour[i]] = i + 1 == tour.size() ? 1 : tour[i+1];
+            }
+        }
+    };
+
+    /**
+     * Broken-pairs distance of two giant tours, the share of the customers of the first one whose successor in it
+     * is not their neighbour in the second one
+     * Time complexity: O(n)
+     */
+    double brokenPairs(const Adjacency &a, const Adjacency &b) {
+        int customers = 0, broken = 0;
+        for (size_t c = 2; c < a.next.size(); c++) {
+            if (a.next[c] == 0) {
+                continue;
+            }
+            customers++;
+            broken += a.next[c] != b.next[c] and a.next[c] != b.previous[c];
+        }
+        return customers == 0 ? 0 : (double)broken / customers;
     }
 
-    auto random_number_generator = default_random_engine();
+    /**
+     * Broken-pairs distances between the members of the population and the biased fitness of hybrid genetic search
+     * The distances are kept in a p x p matrix, a member entering or leaving the population changes only its row
+     * and column, the successors and predecessors of the customers of every member are stored for that
+     */
+    class PopulationDiversity {
+    private:
+        size_t ids;                       // the largest customer ID + 1
+        vector<Adjacency> adjacency;      // of every member
+        vector<vector<double>> distances;
+
+    public:
+        explicit PopulationDiversity(size_t ids) : ids(ids) {}
+
+        void assign(const vector<vector<int>> &population) {
+            adjacency.clear();
+            distances.clear();
+            for (auto &member : population) {
+                add(member);
+            }
+        }
+
+        // Distances of the tour to every member, O(p * n), the members are only read (the offspring of a generation
+        // get theirs in parallel)
+        vector<double> distancesTo(const Adjacency &tour) const {
+            vector<double> row;
+            for (auto &member : adjacency) {
+                row.push_back(brokenPairs(tour, member));
+            }
+            return row;
+        }
+
+        /**
+         * Appends the member with its distances to the members, the negative ones are not known yet and are
+         * calculated, O(p) + O(n) for every unknown distance
+         */
+        void add(Adjacency member, vector<double> row) {
+            size_t added = distances.size();
+            for (size_t other = 0; other < added; other++) {
+                if (row[other] < 0) {
+                    row[other] = brokenPairs(member, adjacency[other]);
+                }
+                distances[other].push_back(row[other]);
+            }
+            row.resize(added + 1, 0);
+            row[added] = 0;
+            distances.push_back(move(row));
+            adjacency.push_back(move(member));
+        }
+
+        // Appends the member, O(p * n) for its distances
+        void add(const vector<int> &member) {
+            Adjacency tour(member, ids);
+            vector<double> row = distancesTo(tour);
+            add(move(tour), move(row));
+        }
+
+        // Removes the member, the last member takes its index (as in the population), O(p)
+        void remove(size_t index) {
+            size_t last = distances.size() - 1;
+            if (index != last) {
+                adjacency[index] = move(adjacency[last]);
+                distances[index] = move(distances[last]);
+                for (size_t row = 0; row < last; row++) {
+                    distances[row][index] = distances[row][last];
+                }
+                distances[index][index] = 0;
+            }
+            adjacency.pop_back();
+            distances.pop_back();
+            for (auto &row : distances) {
+                row.pop_back();
+            }
+        }
 
-    // Add new basic solutions until we reach the wanted population size. 
-    // Note that populationSize shouldn't be higher than (number of customers)! (factorial)
-    // If that wasn't the case, there would be duplicates
+        /**
+         * Finds the member with the worst biased fitness, the rank of its cost plus the weighted rank of its
+         * diversity contribution (the average distance to its closest members), the best member is never chosen
+         * Time complexity: O(p^2)
+         */
+        size_t worstBiased(const vector<double> &scores, double diversityWeight) const {
+            size_t members = scores.size();
+            if (members < 2) {
+                return 0;
+            }
+            vector<double> contribution(members);
+            size_t close = min(CLOSE_MEMBERS, members - 1);
+            for (size_t i = 0; i < members; i++) {
+                vector<double> row = distances[i];
+                row.erase(row.begin() + i);
+                nth_element(row.begin(), row.begin() + (close - 1), row.end());
+                double sum = 0;
+                for (size_t k = 0; k < close; k++) {
+                    sum += row[k];
+                }
+                contribution[i] = sum / close;
+            }
+            vector<size_t> byCost(members), byDiversity(members);
+            for (size_t i = 0; i < members; i++) {
+                byCost[i] = byDiversity[i] = i;
+            }
+            stable_sort(byCost.begin(), byCost.end(), [&](size_t a, size_t b) { return scores[a] < scores[b]; });
+            stable_sort(byDiversity.begin(), byDiversity.end(), [&](size_t a, size_t b) { return contribution[a] > contribution[b]; });
+            vector<double> biased(members, 0);
+            for (size_t rank = 0; rank < members; rank++) {
+                biased[byCost[rank]] += (double)rank / (members - 1);
+                biased[byDiversity[rank]] += diversityWeight * rank / (members - 1);
+            }
+            size_t worst = byCost[members - 1];
+            for (size_t rank = 1; rank < members; rank++) {
+                if (biased[byCost[rank]] > biased[worst]) {
+                    worst = byCost[rank];
+                }
+            }
+            return worst;
+        }
+    };
+}
+
+/**
+ * Function to fill the population with random permutations of the customers not present in it yet, at most with
+ * all n! permutations of a tiny problem
+ * Time complexity: O(populationSize * n)
+ * Space complexity: O(populationSize * n)
+*/
+static void fillRandomly(vector<vector<int>> &population, ChromosomeSet &hashes, const vector<Node> &customers, size_t populationSize) {
+    vector<int> customer_ids;
+    for (size_t i = 1; i < customers.size(); i++) { // Start from 1 because the depot is not a customer (and it's always the first one)
+        customer_ids.push_back(customers[i].id);
+    }
+
+    // Add new basic solutions until we reach the wanted population size.
+    // There are only (number of customers)! distinct permutations, a tiny problem gets a smaller population
+    size_t permutations = 1;
+    for (size_t n = 2; n <= customer_ids.size() and permutations < populationSize; n++) {
+        permutations *= n;
+    }
+    populationSize = min(populationSize, permutations);
     while (population.size() < populationSize) {
-        shuffle(begin(customer_ids), end(customer_ids), random_number_generator); // generate a permutation, O(n)
+        shuffle(begin(customer_ids), end(customer_ids), threadRandom()); // generate a permutation, O(n)
 
-        if(find(population.begin(), population.end(), customer_ids) == population.end()) { // If permutation isn't already present, append it
+        uint64_t hash = chromosomeHash(customer_ids);
+        if (!hashes.contains(hash)) { // If permutation isn't already present, append it
+            hashes.insert(hash);
             population.push_back(customer_ids);
         }
     }
+}
 
+/**
+ * Function to initialize the population randomly
+ * Time complexity: O(populationSize * n), the duplicates are found by the hashes in O(1)
+ * Space complexity: O(n + populationSize * n) = ~O(p*n)
+*/
+vector<vector<int>> initPopulation(const vector<Node> &customers, const size_t &populationSize) {
+    vector<vector<int>> population;
+    ChromosomeSet hashes;
+    fillRandomly(population, hashes, customers, populationSize);
     return population;
 }
 
+/**
+ * Function to check that the giant tour is a permutation of the customers
+ * Time complexity: O(n)
+ * Space complexity: O(n)
+*/
+static bool servesAllCustomers(const vector<int> &tour, const vector<Node> &customers) {
+    if (tour.size() != customers.size() - 1) {
+        return false;
+    }
+    vector<bool> served(customers.size() + 1, false); // the IDs of the customers are 2..n+1
+    for (auto &customer : tour) {
+        if (customer < 2 or customer > (int)customers.size() or served[customer]) {
+            return false;
+        }
+        served[customer] = true;
+    }
+    return true;
+}
+
+/**
+ * Function to build a giant tour by the randomized nearest neighbour heuristic,
+ * the next customer is chosen randomly among the 3 nearest customers not visited yet
+ * Time complexity: O(n^2)
+ * Space complexity: O(n)
+*/
+static vector<int> nearestNeighbourTour(const vector<Node> &customers, const DistanceMatrix &distanceMatrix, uint64_t seed) {
+    Random generator(seed);
+    vector<int> unvisited;
+    for (size_t i = 1; i < customers.size(); i++) {
+        unvisited.push_back(customers[i].id);
+    }
+    vector<int> tour;
+    int current = 0; // the depot
+    while (!unvisited.empty()) {
+        size_t candidates = min((size_t)3, unvisited.size());
+        partial_sort(unvisited.begin(), unvisited.begin() + candidates, unvisited.end(), [&](int a, int b) {
+            return distanceMatrix[current][a-1] < distanceMatrix[current][b-1];
+        });
+        size_t pick = generator() % candidates;
+        tour.push_back(unvisited[pick]);
+        current = unvisited[pick] - 1;
+        unvisited[pick] = unvisited.back();
+        unvisited.pop_back();
+    }
+    return tour;
+}
 
+// Function to concatenate the routes into a giant tour (chromosome)
+static vector<int> giantTour(const vector<vector<int>> &routes) {
+    vector<int> tour;
+    for (auto &route : routes) {
+        tour.insert(tour.end(), route.begin(), route.end());
+    }
+    return tour;
+}
+
+/**
+ * Function to initialize the population with the solutions of the constructive heuristics
+ * The savings solution (only up to SAVINGS_SEED_LIMIT customers, it grows too slowly beyond), the best sweep and
+ * NEAREST_NEIGHBOUR_SEEDS randomized nearest neighbour tours are built in parallel and converted into chromosomes,
+ * the rest of the population is random
+ * Time complexity: O(savings + n log n + s * n^2) for s nearest neighbour tours, then O(p*n) for the random members
+ * Space complexity: O(p*n)
+*/
+vector<vector<int>> hybridPopulation(const vector<Node> &customers, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix, size_t populationSize, size_t threads) {
+    vector<function<vector<int>()>> constructors;
+    if (customers.size() - 1 <= SAVINGS_SEED_LIMIT) {
+        constructors.push_back([&]() { return giantTour(savingsAlgorithm(customers, requests, fleet, distanceMatrix).routes); });
+    }
+    constructors.push_back([&]() { return giantTour(sweep(customers, requests, fleet, distanceMatrix).routes); });
+    uint64_t baseSeed = threadSeed(); // the tours are built on other threads, each gets its own stream
+    for (unsigned int stream = 1; stream <= NEAREST_NEIGHBOUR_SEEDS; stream++) {
+        uint64_t seed = streamSeed(baseSeed, stream);
+        constructors.push_back([&, seed]() { return nearestNeighbourTour(customers, distanceMatrix, seed); });
+    }
+
+    vector<vector<int>> tours(constructors.size());
+    vector<exception_ptr> errors(constructors.size());
+    {
+        ThreadPool pool(min(threads, constructors.size()));
+        for (size_t c = 0; c < constructors.size(); c++) {
+            pool.submit([&, c]() {
+                try {
+                    tours[c] = constructors[c]();
+                } catch (...) {
+                    errors[c] = current_exception();
+                }
+            });
+        }
+        pool.wait();
+    }
+    for (auto &error : errors) {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+
+    // the same tour built twice is kept once, in the order of the constructors so the result does not depend on the threads,
+    // a tour that does not serve every customer exactly once (a constructor that gave up on a customer) is left out
+    vector<vector<int>> population;
+    ChromosomeSet hashes;
+    for (auto &tour : tours) {
+        if (population.size() < populationSize and servesAllCustomers(tour, customers) and !hashes.contains(chromosomeHash(tour))) {
+            hashes.insert(chromosomeHash(tour));
+            population.push_back(tour);
+        }
+    }
+    fillRandomly(population, hashes, customers, populationSize);
+    return population;
+}
 
 /**
  * Function to calculate the distance in the given route using the preCalculated distanceMatrix
- * Implicitly adds the distance from the depot to the first customer and the distance from the last customer back to the depot
+ * Implicitly adds the distance from the depot to the first customer and the distance from the last customer back to the depot, an empty route has no distance
  * Time complexity: O(n) - worst case => current route contains all customers
  * Space complexity: O(1)
 */
-double calculateCustomerDistance(const vector<int> &current_route, const vector<vector<double>> &distanceMatrix) {
+double calculateCustomerDistance(const vector<int> &current_route, const DistanceMatrix &distanceMatrix) {
     double total_dist = 0;
+    if (current_route.empty()) {
+        return total_dist;
+    }
 
     // Add distance from depot to the first customer
     int customer_matrix_position = current_route[0]-1; // Customer 1 is on the position 0 because numbering starts from 1
@@ -68,13 +485,90 @@ double calculateCustomerDistance(const vector<int> &current_route, const vector<
     return total_dist;
 }
 
+/**
+ * Function to calculate the fitness of the solution on the integer (rounded) distance matrix
+ * Same splitting as fitness(), but the distances are summed as integers directly from the matrix rows
+ * without building the routes, so the sums are exact and the loop does not allocate
+ * Time complexity: O(n)
+ * Space complexity: O(1)
+*/
+static double integerFitness(const vector<int> &solution, const vector<Request> &requests, double vehicleCapacity, int maxVehicles, const DistanceMatrix &distanceMatrix) {
+    const int32_t* depot_row = distanceMatrix.integerRow(0);
+    double vehicle_capacity = vehicleCapacity;
+    int vehicles_penalty = 0;
+    int64_t travelled_distance = 0;
+    int prev_customer = 0; // the depot
+
+    for (auto &customer_id : solution) {
+        auto load = requests[customer_id - 2].quantity; // customer with ID 2 has request n. 0
+        vehicle_capacity -= load;
+        int customer_position = customer_id - 1;
+        if (prev_customer == 0) { // the first route starts here
+            travelled_distance += depot_row[customer_position];
+            vehicles_penalty++;
+            vehicle_capacity = vehicleCapacity - load;
+        } else if (vehicle_capacity < 0) { // return to the depot and start a new route with another vehicle
+            vehicles_penalty++;
+            vehicle_capacity = vehicleCapacity - load;
+            travelled_distance += distanceMatrix.integerRow(prev_customer)[0] + depot_row[customer_position];
+        } else {
+            travelled_distance += distanceMatrix.integerRow(prev_customer)[customer_position];
+        }
+        prev_customer = customer_position;
+    }
+    travelled_distance += distanceMatrix.integerRow(prev_customer)[0]; // back to the depot
+
+    if (maxVehicles >= 0 and vehicles_penalty > maxVehicles) { // more trucks than exist
+        return (double)travelled_distance + vehicles_penalty + (vehicles_penalty - maxVehicles) * excessVehiclePenalty(solution, distanceMatrix);
+    }
+    return (double)travelled_distance + vehicles_penalty;
+}
+
+// Fitness of the solutions already evaluated with a heterogeneous fleet on this thread, see fleetFitness()
+static thread_local unordered_map<uint64_t, double> fleetFitnessCache;
+
+/**
+ * Function to calculate the fitness of the solution with a heterogeneous fleet or time windows
+ * The fleet-aware split is much more expensive than the greedy one and the population is evaluated over and over
+ * while only a member or two change per iteration, so the results are remembered. The key is a hash of the solution
+ * and of the addresses of the requests, the fleet and the matrix, not of their contents (that would cost O(n^2) for
+ * the matrix), so the problem must not be modified while the cache holds its solutions: genetic() clears the cache
+ * of its thread at its start and end, a caller of fitness() outside of genetic() has to keep the problem unchanged
+ * Time complexity: O(n) on a hit, otherwise see splitFleet()
+ * Space complexity: O(1) per evaluated solution
+*/
+static double fleetFitness(const vector<int> &solution, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix) {
+    const void* problem[] = {requests.data(), &fleet, &distanceMatrix};
+    uint64_t key = hashBytes(solution.data(), solution.size() * sizeof(int), hashBytes(problem, sizeof(problem)));
+    auto cached = fleetFitnessCache.find(key);
+    if (cached != fleetFitnessCache.end()) {
+        return cached->second;
+    }
+    FleetSplit split = splitFleet(solution, requests, fleet, distanceMatrix, false);
+    double score = split.distance + split.vehicles + split.excessVehicles * excessVehiclePenalty(solution, distanceMatrix) +
+                   split.timeWarp * TIME_WARP_PENALTY;
+    if (fleetFitnessCache.size() > 100000) { // only the recent solutions are worth keeping
+        fleetFitnessCache.clear();
+    }
+    fleetFitnessCache.emplace(key, score);
+    return score;
+}
+
 /**
  * Function to calculate the fitness of the solution
  * Adds euclidean distances between each point and adds a penalty in the form of the amount of vehicles needed to fulfill the route (capacity constraint)
  * Time complexity: O(n) // customer distance called max n times
  * Space complexity: O(n) // current route which may contain at most N customers
 */
-double fitness(const vector<int> &solution, const vector<Request> &requests, const double &vehicleCapacity, const vector<vector<double>> &distanceMatrix) {
+double fitness(const vector<int> &solution, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix) {
+    if (!fleet.isUniform() or fleet.timeWindows) { // the vehicles differ or have to meet the time windows, the routes are split optimally
+        return fleetFitness(solution, requests, fleet, distanceMatrix);
+    }
+    double vehicleCapacity = fleet.maxCapacity();
+    if (distanceMatrix.integerRow(0) != nullptr) {
+        return integerFitness(solution, requests, vehicleCapacity, fleet.maxVehicles, distanceMatrix);
+    }
+
     double vehicle_capacity = vehicleCapacity; // all vehicle share the same capacity
     double total_vehicle_capacity = vehicle_capacity;
     int vehicles_penalty = 0;
@@ -87,8 +581,7 @@ double fitness(const vector<int> &solution, const vector<Request> &requests, con
         auto request_id = customer_id - 2; // the requests always start with node 2 (because 1 is the depot) and therefore customer with ID 2 has request n. 0
         auto req = requests[request_id];
         if (req.whereto.id != customer_id) {
-            cerr << "This should not happen, means there was a mismatch in the data file and therefore reuqest need to use a hashtable instead of a sorted vector" << endl;
-            exit(1);
+            throw runtime_error("This should not happen, means there was a mismatch in the data file and therefore request need to use a hashtable instead of a sorted vector");
         }
         auto load = req.quantity;
         vehicle_capacity -= load;
@@ -110,6 +603,9 @@ double fitness(const vector<int> &solution, const vector<Request> &requests, con
         vehicles_penalty++;
     }
     auto total_fitness = travelled_distance + vehicles_penalty;
+    if (fleet.maxVehicles >= 0 and vehicles_penalty > fleet.maxVehicles) { // more trucks than exist, the solution will need a repair
+        total_fitness += (vehicles_penalty - fleet.maxVehicles) * excessVehiclePenalty(solution, distanceMatrix);
+    }
     return total_fitness;
 }
 
@@ -118,8 +614,8 @@ double fitness(const vector<int> &solution, const vector<Request> &requests, con
  * Time complexity: O(n)
  * Space complexity: O(2n) // because route may be at most O(n) and this is then copied into routes which is another O(n)
 */
-vector<vector<int>> getRoutes(const vector<int> &solution, const vector<Request> &requests, const double &vehicleCapacity) {
-    double vehicle_capacity = vehicleCapacity; // all vehicle share the same capacity
+vector<vector<int>> getRoutes(const vector<int> &solution, const vector<Request> &requests, const Fleet &fleet) {
+    double vehicle_capacity = fleet.maxCapacity(); // all vehicle share the same capacity (the largest one for a heterogeneous fleet, see splitFleet())
     double total_vehicle_capacity = vehicle_capacity;
     vector<vector<int>> routes;
 
@@ -130,8 +626,7 @@ vector<vector<int>> getRoutes(const vector<int> &solution, const vector<Request>
         auto request_id = customer_id - 2; // the requests always start with node 2 (because 1 is the depot) and therefore customer with ID 2 has request n. 0
         auto req = requests[request_id];
         if (req.whereto.id != customer_id) {
-            cerr << "This should not happen, means there was a mismatch in the data file and therefore request need to use a hashtable instead of a sorted vector" << endl;
-            exit(1);
+            throw runtime_error("This should not happen, means there was a mismatch in the data file and therefore request need to use a hashtable instead of a sorted vector");
         }
         auto load = req.quantity;
         vehicle_capacity -= load;
@@ -159,14 +654,17 @@ vector<vector<int>> getRoutes(const vector<int> &solution, const vector<Request>
  * Time complexity: weird because of random(), most of the time it will be O(1) + O(n) => O(n) // all routes only have at most N customers
  * Space complexity: O(2n) // getRoutes
 */
-vector<int> mutation(const vector<int> &solution, const vector<Request> &requests, const double &vehicleCapacity) {
-    vector<vector<int>> routes = getRoutes(solution, requests, vehicleCapacity);
+vector<int> mutation(const vector<int> &solution, const vector<Request> &requests, const Fleet &fleet) {
+    vector<vector<int>> routes = getRoutes(solution, requests, fleet);
+    if (routes.size() < 2) { // nothing to swap between (e.g. a depot with a few customers in a multi-depot problem)
+        return solution;
+    }
 
     int route_index1; int route_index2;
     // choose the routes from which we will randomly swap, they must not be the same
     while (true) {
-        route_index1 = rand() % routes.size();
-        route_index2 = rand() % routes.size();
+        route_index1 = randomNumber() % routes.size();
+        route_index2 = randomNumber() % routes.size();
 
         if (route_index1 != route_index2) {
             break;
@@ -174,8 +672,8 @@ vector<int> mutation(const vector<int> &solution, const vector<Request> &request
     }
 
     // pick a random customer in each of those routes
-    auto customer_index1 = rand() % routes[route_index1].size();
-    auto customer_index2 = rand() % routes[route_index2].size();
+    auto customer_index1 = randomNumber() % routes[route_index1].size();
+    auto customer_index2 = randomNumber() % routes[route_index2].size();
 
     // swap the customers in the routes
     auto tmp = routes[route_index1][customer_index1];
@@ -198,18 +696,24 @@ vector<int> mutation(const vector<int> &solution, const vector<Request> &request
  * Time complexity: O(2n) // fitness * 2
  * Space complexity: O(1)
 */
-vector<int> binaryTournament(const vector<vector<int>> &population, const vector<Request> &requests, const double &vehicleCapacity, const vector<vector<double>> &distanceMatrix) {
+static vector<int> tournament(const vector<vector<int>> &population, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix, double &score) {
     auto pop_size = population.size();
 
-    auto potentialParent1 = population[rand() % pop_size];
-    auto potentialParent2 = population[rand() % pop_size];
+    auto potentialParent1 = population[randomNumber() % pop_size];
+    auto potentialParent2 = population[randomNumber() % pop_size];
 
-    auto p1_score = fitness(potentialParent1, requests, vehicleCapacity, distanceMatrix); // calculate how good the potential parent 1 is
-    auto p2_score = fitness(potentialParent2, requests, vehicleCapacity, distanceMatrix);
+    auto p1_score = fitness(potentialParent1, requests, fleet, distanceMatrix); // calculate how good the potential parent 1 is
+    auto p2_score = fitness(potentialParent2, requests, fleet, distanceMatrix);
 
+    score = min(p1_score, p2_score);
     return (p1_score > p2_score ? potentialParent1 : potentialParent2); // pick the better parent
 }
 
+vector<int> binaryTournament(const vector<vector<int>> &population, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix) {
+    double score;
+    return tournament(population, requests, fleet, distanceMatrix, score);
+}
+
 /**
  * Function to apply the ordered crossover to generate new offspring
  * Time complexity: O(n * (4n)) + O(n) => O(4n^2)
@@ -223,8 +727,8 @@ pair<vector<int>, vector<int>> orderedCrossover(const vector<int> &parent1, cons
     vector<int> offspring1(parent1.size(), -1);
     vector<int> offspring2(parent1.size(), -1);
 
-    auto lower_boundary = rand() % parent1.size();
-    auto upper_boundary = rand() % parent1.size();
+    auto lower_boundary = randomNumber() % parent1.size();
+    auto upper_boundary = randomNumber() % parent1.size();
 
     // If lower > upper, swap them
     if (lower_boundary > upper_boundary) {
@@ -260,24 +764,219 @@ pair<vector<int>, vector<int>> orderedCrossover(const vector<int> &parent1, cons
     return make_pair(offspring1, offspring2);
 }
 
+/**
+ * Function to get the position of every customer of the solution, indexed by the customer ID (-1 if absent)
+ * Time complexity: O(n)
+ * Space complexity: O(n)
+*/
+static vector<int> customerPositions(const vector<int> &solution) {
+    int largest = solution.empty() ? 0 : *max_element(solution.begin(), solution.end());
+    vector<int> positions(largest + 1, -1);
+    for (size_t i = 0; i < solution.size(); i++) {
+        positions[solution[i]] = i;
+    }
+    return positions;
+}
+
+/**
+ * Function to apply the partially mapped crossover (PMX), the child keeps a random segment of one parent and the rest
+ * of the positions of the other parent, a customer already in the segment is replaced through the mapping of the segment
+ * Time complexity: O(n)
+ * Space complexity: O(n)
+*/
+pair<vector<int>, vector<int>> partiallyMappedCrossover(const vector<int> &parent1, const vector<int> &parent2) {
+    auto lower_boundary = randomNumber() % parent1.size();
+    auto upper_boundary = randomNumber() % parent1.size();
+    if (lower_boundary > upper_boundary) {
+        swap(lower_boundary, upper_boundary);
+    }
+    auto cross = [&](const vector<int> &segment_parent, const vector<int> &other_parent) {
+        vector<int> offspring = other_parent;
+        vector<int> segment_positions = customerPositions(segment_parent);
+        vector<bool> in_segment(segment_positions.size(), false);
+        for (auto i = lower_boundary; i <= upper_boundary; i++) {
+            offspring[i] = segment_parent[i];
+            in_segment[segment_parent[i]] = true;
+        }
+        for (size_t i = 0; i < offspring.size(); i++) {
+            if (i >= lower_boundary and i <= upper_boundary) {
+                continue;
+            }
+            int customer = other_parent[i];
+            while (in_segment[customer]) { // follow the mapping until the customer is not in the segment
+                customer = other_parent[segment_positions[customer]];
+            }
+            offspring[i] = customer;
+        }
+        return offspring;
+    };
+    return make_pair(cross(parent1, parent2), cross(parent2, parent1));
+}
+
+/**
+ * Function to apply the edge recombination crossover (ERX), the child is built from the edges of both parents,
+ * the next customer is the neighbour of the last one with the fewest remaining neighbours (a random unvisited
+ * customer if there is none), the children start with the first customer of either parent
+ * Time complexity: O(n)
+ * Space complexity: O(n)
+*/
+pair<vector<int>, vector<int>> edgeRecombinationCrossover(const vector<int> &parent1, const vector<int> &parent2) {
+    size_t size = parent1.size();
+    int largest = *max_element(parent1.begin(), parent1.end());
+    // the neighbours of every customer in both parents (at most 4, the duplicates are kept once)
+    vector<array<int, 4>> neighbours(largest + 1);
+    vector<int> degrees(largest + 1, 0);
+    for (auto parent : {&parent1, &parent2}) {
+        for (size_t i = 0; i < size; i++) {
+            int customer = (*parent)[i];
+            for (int neighbour : {(*parent)[(i + size - 1) % size], (*parent)[(i + 1) % size]}) {
+                auto &list = neighbours[customer];
+                if (neighbour != customer and find(list.begin(), list.begin() + degrees[customer], neighbour) == list.begin() + degrees[customer]) {
+                    list[degrees[customer]++] = neighbour;
+                }
+            }
+        }
+    }
+
+    auto recombine = [&](int first) {
+        vector<int> remaining = degrees;
+        vector<int> unvisited(parent1); // with the positions, so a customer is removed in O(1)
+        vector<int> unvisited_positions = customerPositions(unvisited);
+        vector<int> offspring;
+        offspring.reserve(size);
+        int current = first;
+        while (true) {
+            offspring.push_back(current);
+            size_t position = unvisited_positions[current];
+            unvisited_positions[unvisited.back()] = position;
+            unvisited[position] = unvisited.back();
+            unvisited.pop_back();
+            unvisited_positions[current] = -1;
+            if (unvisited.empty()) {
+                break;
+            }
+            int next = -1;
+            for (int k = 0; k < degrees[current]; k++) {
+                int neighbour = neighbours[current][k];
+                if (unvisited_positions[neighbour] < 0) {
+                    continue;
+                }
+                remaining[neighbour]--; // the edge to the current customer is used up
+                if (next < 0 or remaining[neighbour] < remaining[next] or (remaining[neighbour] == remaining[next] and randomNumber() % 2 == 0)) {
+                    next = neighbour;
+                }
+            }
+            current = next >= 0 ? next : unvisited[randomNumber() % unvisited.size()];
+        }
+        return offspring;
+    };
+    return make_pair(recombine(parent1[0]), recombine(parent2[0]));
+}
+
+/**
+ * Function to apply the selective route exchange crossover (SREX) on the giant tours, the child starts with a random
+ * run of consecutive routes of one parent (split by getRoutes()) followed by the other customers in the order
+ * of the other parent
+ * Time complexity: O(n)
+ * Space complexity: O(n)
+*/
+pair<vector<int>, vector<int>> selectiveRouteExchange(const vector<int> &parent1, const vector<int> &parent2, const vector<Request> &requests, const Fleet &fleet) {
+    auto cross = [&](const vector<int> &route_parent, const vector<int> &other_parent) {
+        vector<vector<int>> routes = getRoutes(route_parent, requests, fleet);
+        size_t count = 1 + randomNumber() % max((size_t)1, routes.size() / 2);
+        size_t first = randomNumber() % routes.size();
+        vector<int> offspring;
+        offspring.reserve(route_parent.size());
+        for (size_t r = 0; r < count; r++) {
+            auto &route = routes[(first + r) % routes.size()];
+            offspring.insert(offspring.end(), route.begin(), route.end());
+        }
+        vector<bool> taken(customerPositions(route_parent).size(), false);
+        for (auto &customer : offspring) {
+            taken[customer] = true;
+        }
+        for (auto &customer : other_parent) {
+            if (!taken[customer]) {
+                offspring.push_back(customer);
+            }
+        }
+        return offspring;
+    };
+    return make_pair(cross(parent1, parent2), cross(parent2, parent1));
+}
+
+/**
+ * Function to apply the mutation that moves a random customer to a random position
+ * Time complexity: O(n)
+ * Space complexity: O(n)
+*/
+vector<int> relocateMutation(const vector<int> &solution) {
+    vector<int> mutant = solution;
+    if (mutant.size() < 2) {
+        return mutant;
+    }
+    size_t from = randomNumber() % mutant.size();
+    size_t to = randomNumber() % mutant.size();
+    int customer = mutant[from];
+    mutant.erase(mutant.begin() + from);
+    mutant.insert(mutant.begin() + to, customer);
+    return mutant;
+}
+
+/**
+ * Function to apply the mutation that reverses a random segment of the solution (a 2-opt move of the giant tour)
+ * Time complexity: O(n)
+ * Space complexity: O(n)
+*/
+vector<int> inversionMutation(const vector<int> &solution) {
+    vector<int> mutant = solution;
+    if (mutant.size() < 2) {
+        return mutant;
+    }
+    size_t lower_boundary = randomNumber() % mutant.size();
+    size_t upper_boundary = randomNumber() % mutant.size();
+    if (lower_boundary > upper_boundary) {
+        swap(lower_boundary, upper_boundary);
+    }
+    reverse(mutant.begin() + lower_boundary, mutant.begin() + upper_boundary + 1);
+    return mutant;
+}
+
+vector<CrossoverOperator> crossoverOperators() {
+    return {
+        {"ox", [](const vector<int> &parent1, const vector<int> &parent2, const vector<Request> &, const Fleet &) { return orderedCrossover(parent1, parent2); }},
+        {"pmx", [](const vector<int> &parent1, const vector<int> &parent2, const vector<Request> &, const Fleet &) { return partiallyMappedCrossover(parent1, parent2); }},
+        {"erx", [](const vector<int> &parent1, const vector<int> &parent2, const vector<Request> &, const Fleet &) { return edgeRecombinationCrossover(parent1, parent2); }},
+        {"srex", selectiveRouteExchange},
+    };
+}
+
+vector<MutationOperator> mutationOperators() {
+    return {
+        {"swap", mutation},
+        {"relocate", [](const vector<int> &solution, const vector<Request> &, const Fleet &) { return relocateMutation(solution); }},
+        {"inversion", [](const vector<int> &solution, const vector<Request> &, const Fleet &) { return inversionMutation(solution); }},
+    };
+}
+
 /**
  * Function to calculate the fitness value of each member of the population and return the worst score & corresponding member
  * Time complexity: O(p * (n)) => O(p*n)
  * Space complexity: O(2n) // best & worst members
 */
-pair<pair<double,double>, pair<vector<int>, vector<int>>> populationFitness(const vector<vector<int>> &population, const vector<Request> &requests, const double &vehicleCapacity, const vector<vector<double>> &distanceMatrix) {
+pair<pair<double,double>, pair<vector<int>, vector<int>>> populationFitness(const vector<vector<int>> &population, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix) {
     double highest_score = 0;
     double lowest_score = __DBL_MAX__;
     vector<int> worst_member;
     vector<int> best_member;
     for (auto &member : population) {
-        auto score = fitness(member, requests, vehicleCapacity, distanceMatrix);
+        auto score = fitness(member, requests, fleet, distanceMatrix);
         // If his result is worse (higher), mark him as the new worst
         if (score > highest_score) {
             highest_score = score;
             worst_member = member;
         }
-        else if (score < lowest_score) {
+        if (score < lowest_score) {
             lowest_score = score;
             best_member = member;
         }
@@ -296,25 +995,190 @@ void removeMember(vector<vector<int>> &population, const vector<int> &to_remove)
 }
 
 /**
- * Function to calculate unused capacity for a car on a given route - it supposes the route is already optimalized for only 1 car
- * Time complexity: O(n)
- * Space complexity: O(1)
+ * Function to seed the population with a previous solution
+ * The first half of the population is replaced by the solution and its copies perturbed by 1 to 3 mutations,
+ * the random members of the other half keep the population diverse
+ * Time complexity: O(p*n) // mutations
+ * Space complexity: O(p*n)
 */
-double findUnusedCapacity(const vector<int> &route, const vector<Request> &requests, const double &vehicleCapacity) {
-    auto vehicle_capacity = vehicleCapacity;
-    for (auto &customer_id : route) { // go through each node representing a customer in the solution
-        // find the requested amount of the goods
-        auto request_id = customer_id - 2; // the requests always start with node 2 (because 1 is the depot) and therefore customer with ID 2 has request n. 0
-        auto req = requests[request_id];
-        if (req.whereto.id != customer_id) {
-            cerr << "This should not happen, means there was a mismatch in the data file and therefore request need to use a hashtable instead of a sorted vector" << endl;
-            exit(1);
+static void seedPopulation(vector<vector<int>> &population, const vector<vector<int>> &routes, const vector<Request> &requests, const Fleet &fleet) {
+    vector<int> tour;
+    for (auto &route : routes) {
+        tour.insert(tour.end(), route.begin(), route.end());
+    }
+    for (size_t i = 0; i < (population.size() + 1) / 2; i++) {
+        population[i] = tour;
+        for (size_t m = 0; i > 0 and m < 1 + i % 3; m++) {
+            population[i] = mutation(population[i], requests, fleet);
         }
-        auto load = req.quantity;
-        vehicle_capacity -= load;
     }
-    
-    return vehicle_capacity;
+}
+
+/**
+ * Function to split the solution into routes the same way as the final solution is split
+ * Time complexity: O(n) for a uniform fleet without time windows, otherwise see splitFleet()
+ * Space complexity: O(n)
+*/
+static vector<vector<int>> splitTour(const vector<int> &solution, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix) {
+    if (fleet.isUniform() and !fleet.timeWindows) {
+        return getRoutes(solution, requests, fleet);
+    }
+    return splitFleet(solution, requests, fleet, distanceMatrix, true).routes;
+}
+
+/**
+ * Function to exchange the solutions with the other engines through the incumbent
+ * The best member is published, a better solution of another engine replaces the worst member
+ * Time complexity: O(p*n) // fitness of the population
+ * Space complexity: O(n)
+*/
+static void exchangeIncumbent(vector<vector<int>> &population, double &publishedCost, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix, Incumbent &incumbent) {
+    size_t best = 0, worst = 0;
+    vector<double> scores;
+    for (auto &member : population) {
+        scores.push_back(fitness(member, requests, fleet, distanceMatrix));
+    }
+    for (size_t i = 1; i < population.size(); i++) {
+        best = scores[i] < scores[best] ? i : best;
+        worst = scores[i] > scores[worst] ? i : worst;
+    }
+    vector<vector<int>> routes = splitTour(population[best], requests, fleet, distanceMatrix);
+    double cost = incumbent.cost(routes);
+    if (cost < publishedCost - 1e-9) {
+        incumbent.offer(routes, "genetic");
+        publishedCost = cost;
+    }
+    const IncumbentSolution* shared = incumbent.best();
+    if (shared != nullptr and shared->cost < publishedCost - 1e-9) {
+        vector<int> tour;
+        for (auto &route : shared->routes) {
+            tour.insert(tour.end(), route.begin(), route.end());
+        }
+        population[worst] = tour;
+        publishedCost = shared->cost;
+    }
+}
+
+namespace {
+    /**
+     * Adaptive pursuit of the operators, the reward of every operator is estimated by a moving average and the
+     * probability of the operator with the best estimate moves towards the largest one allowed, the probabilities
+     * of the others towards OPERATOR_MIN_PROBABILITY
+     */
+    class OperatorSelector {
+    private:
+        vector<double> probabilities;
+        vector<double> rewards;
+
+    public:
+        explicit OperatorSelector(size_t operators) : probabilities(operators, 1.0 / operators), rewards(operators, 0) {}
+
+        size_t choose() const {
+            double pick = threadRandom().unit();
+            for (size_t o = 0; o + 1 < probabilities.size(); o++) {
+                if (pick < probabilities[o]) {
+                    return o;
+                }
+                pick -= probabilities[o];
+            }
+            return probabilities.size() - 1;
+        }
+
+        void update(size_t chosen, double reward) {
+            rewards[chosen] += OPERATOR_ADAPTATION_RATE * (reward - rewards[chosen]);
+            size_t best = max_element(rewards.begin(), rewards.end()) - rewards.begin();
+            if (rewards[best] <= 0) { // nothing has improved yet
+                return;
+            }
+            double smallest = min(OPERATOR_MIN_PROBABILITY, 1.0 / probabilities.size());
+            double largest = 1 - smallest * (probabilities.size() - 1);
+            for (size_t o = 0; o < probabilities.size(); o++) {
+                probabilities[o] += OPERATOR_ADAPTATION_RATE * ((o == best ? largest : smallest) - probabilities[o]);
+            }
+        }
+    };
+
+    // Operators of the run with their adaptive selection
+    struct GeneticOperators {
+        vector<CrossoverOperator> crossovers;
+        vector<MutationOperator> mutations;
+        OperatorSelector crossoverSelector;
+        OperatorSelector mutationSelector;
+
+        GeneticOperators(vector<CrossoverOperator> crossovers, vector<MutationOperator> mutations)
+            : crossovers(move(crossovers)), mutations(move(mutations)),
+              crossoverSelector(this->crossovers.size()), mutationSelector(this->mutations.size()) {}
+    };
+
+    // Offspring of an iteration with its fitness and the operators that bred it
+    struct Offspring {
+        vector<int> tour;
+        double score = 0;
+        size_t crossover = 0;
+        optional<size_t> mutation;  // none if the offspring was not mutated
+        double crossoverReward = 0; // improvement over the better parent per CPU microsecond if timed, otherwise per call
+        double mutationReward = 0;  // improvement over the child of the crossover
+        uint64_t hash = 0;          // Zobrist hash of the tour
+        // the adjacency of the tour and its distances to the members at the start of the generation, calculated
+        // with the offspring in the generational mode (none for a clone)
+        optional<Adjacency> adjacency;
+        vector<double> memberDistances;
+    };
+}
+
+/**
+ * Function to breed an offspring, the better child of the crossover of two parents chosen by binary tournaments is
+ * mutated with the mutation rate, a clone of a member is mutated a few more times (it is rejected if it stays a clone)
+ * The operators are chosen by their adaptive probabilities, the population and the operators are only read,
+ * so the offspring of a generation can be bred in parallel
+ * Time complexity: O(n) + the fitness of at most 7 + CLONE_MUTATIONS solutions
+ * Space complexity: O(n)
+*/
+static Offspring breed(const vector<vector<int>> &population, const ChromosomeSet &hashes, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix,
+                       const GeneticOperators &operators, double mutationRate, bool timed) {
+    long long start = timed ? threadCpuNanoseconds() : 0;
+    auto cost = [&]() { // CPU microseconds since the start (at least 1), 1 if not timed
+        double microseconds = timed ? (threadCpuNanoseconds() - start) / 1000.0 : 1;
+        start = timed ? threadCpuNanoseconds() : 0;
+        return max(microseconds, 1.0);
+    };
+
+    // Select parents using the binary tournament method
+    double parent1_score, parent2_score;
+    vector<int> parent1 = tournament(population, requests, fleet, distanceMatrix, parent1_score);
+    vector<int> parent2 = tournament(population, requests, fleet, distanceMatrix, parent2_score);
+
+    // Create the offsprings using the chosen crossover and evaluate them
+    Offspring better;
+    better.crossover = operators.crossoverSelector.choose();
+    start = timed ? threadCpuNanoseconds() : 0;
+    pair<vector<int>, vector<int>> offsprings = operators.crossovers[better.crossover].apply(parent1, parent2, requests, fleet);
+    auto offspring1_score = fitness(offsprings.first, requests, fleet, distanceMatrix);
+    auto offspring2_score = fitness(offsprings.second, requests, fleet, distanceMatrix);
+
+    // Choose the better offspring to use as a replacement (Another approach would be to use both - the better to replace the worst, then recalculate and the other replace the next worst)
+    better.tour = offspring1_score > offspring2_score ? move(offsprings.second) : move(offsprings.first);
+    better.score = min(offspring1_score, offspring2_score);
+    better.crossoverReward = max(0.0, min(parent1_score, parent2_score) - better.score) / cost();
+
+    // Mutate the offspring with a certain probability
+    if (threadRandom().unit() < mutationRate) {
+        better.mutation = operators.mutationSelector.choose();
+        vector<int> mutant = operators.mutations[*better.mutation].apply(better.tour, requests, fleet);
+        double mutant_score = fitness(mutant, requests, fleet, distanceMatrix);
+        better.mutationReward = max(0.0, better.score - mutant_score) / cost();
+        better.tour = move(mutant);
+        better.score = mutant_score;
+    }
+
+    // A clone would only crowd out the diversity of the population
+    better.hash = chromosomeHash(better.tour);
+    for (int attempt = 0; attempt < CLONE_MUTATIONS and hashes.contains(better.hash); attempt++) {
+        better.tour = operators.mutations[operators.mutationSelector.choose()].apply(better.tour, requests, fleet);
+        better.score = fitness(better.tour, requests, fleet, distanceMatrix);
+        better.hash = chromosomeHash(better.tour);
+    }
+    return better;
 }
 
 /**
@@ -323,105 +1187,221 @@ double findUnusedCapacity(const vector<int> &route, const vector<Request> &reque
  * => O(p*n) + O(i*(n*(10+p) +4n^2)) + O(50n) => with our numbers O(3e6 n + 2e5 n^2) = O(n^2), but the coefficient of the N makes it more linear
  * Space complexity: O(50n) + O(1 + 4n + 2* 2n + 2n + 2n + 1) => O(62n)
 */
-void genetic(const vector<Node>& nodes, const vector<Request>& requests, const double &vehicleCapacity)  {
+Solution genetic(const vector<Node>& nodes, const vector<Request>& requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix, const GeneticOptions &options)  {
 
-    size_t iteration_limit = 50000;
+    size_t iteration_limit = options.iterations;
     auto customers = nodes;
-    auto distanceMatrix = calculateDistanceMatrix(customers); // O(n^2) but we dont count this cuz its not part of the algo itself
-
+    fleetFitnessCache.clear();
 
     // TIMESTAMP: Record time before the algorithm starts
     auto algorithmStart = chrono::high_resolution_clock::now();
 
-    auto population = initPopulation(customers, 50); // 50 seems ok
+    PhaseTimer constructTimer;
+    auto population = options.hybridPopulation ? hybridPopulation(customers, requests, fleet, distanceMatrix, options.populationSize, options.threads)
+                                               : initPopulation(customers, options.populationSize);
+    if (!options.initialRoutes.empty()) {
+        seedPopulation(population, options.initialRoutes, requests, fleet);
+    }
+    double publishedCost = __DBL_MAX__;
+    if (options.incumbent != nullptr) { // the solution of another engine (savings in the portfolio) joins the population
+        exchangeIncumbent(population, publishedCost, requests, fleet, distanceMatrix, *options.incumbent);
+    }
+    ChromosomeSet hashes; // hashes of the members, an offspring identical to a member is a clone
+    hashes.assign(population);
+    PopulationDiversity diversity(requests.size() + 2);
+    vector<double> scores;
+    if (options.biasedFitness) {
+        diversity.assign(population);
+        for (auto &member : population) {
+            scores.push_back(fitness(member, requests, fleet, distanceMatrix));
+        }
+    }
+    auto constructTime = constructTimer.elapsed();
+
+    PhaseTimer improveTimer;
+    auto searchStart = chrono::steady_clock::now();
 
-    // Running the algorithm
-    for (size_t i = 0; i < iteration_limit; i++) {
-        // Select parents using the binary tournament method
-        vector<int> parent1 = binaryTournament(population, requests, vehicleCapacity, distanceMatrix);
-        vector<int> parent2 = binaryTournament(population, requests, vehicleCapacity, distanceMatrix);
+    GeneticOperators operators(options.crossovers.empty() ? crossoverOperators() : options.crossovers,
+                               options.mutations.empty() ? mutationOperators() : options.mutations);
 
-        // Create an offspring using ordered crossover
-        pair<vector<int>, vector<int>> offsprings = orderedCrossover(parent1, parent2);
-        auto offspring1 = offsprings.first;
-        auto offspring2 = offsprings.second;
+    // In the generational mode, every member has its index in the population at the start of the generation, or
+    // the start size plus the index of the offspring that joined during the generation (its distances are unknown)
+    vector<size_t> origins;
+    size_t generationStart = 0;
 
-        // Mutate the offspring with a certain probability
-        offspring1 = mutation(offspring1, requests, vehicleCapacity);
-        offspring2 = mutation(offspring2, requests, vehicleCapacity);
+    // The operators are rewarded and the offspring joins the population if it is better than the worst member and not a clone
+    auto survive = [&](Offspring &child, size_t index) {
+        operators.crossoverSelector.update(child.crossover, child.crossoverReward);
+        if (child.mutation) {
+            operators.mutationSelector.update(*child.mutation, child.mutationReward);
+        }
+        if (hashes.contains(child.hash)) {
+            return;
+        }
+        if (options.biasedFitness) {
+            // then the member with the worst biased fitness (maybe the offspring) leaves
+            if (child.score < *max_element(scores.begin(), scores.end())) {
+                // the origins are kept only in the generational mode, always together with the diversity
+                bool tracked = !origins.empty();
+                if (child.adjacency) {
+                    vector<double> row;
+                    for (auto &origin : origins) {
+                        row.push_back(origin < generationStart ? child.memberDistances[origin] : -1);
+                    }
+                    diversity.add(move(*child.adjacency), move(row));
+                } else {
+                    // a clone of a member evicted during the generation got no distances in the pool
+                    diversity.add(child.tour);
+                }
+                if (tracked) {
+                    origins.push_back(generationStart + index);
+                }
+                population.push_back(move(child.tour));
+                scores.push_back(child.score);
+                hashes.insert(child.hash);
+                size_t survivor_out = diversity.worstBiased(scores, options.diversityWeight);
+                hashes.erase(chromosomeHash(population[survivor_out]));
+                population[survivor_out] = move(population.back());
+                population.pop_back();
+                scores[survivor_out] = scores.back();
+                scores.pop_back();
+                diversity.remove(survivor_out);
+                if (tracked) {
+                    origins[survivor_out] = origins.back();
+                    origins.pop_back();
+                }
+            }
+            return;
+        }
 
         // Find the worst score in population and the correspnding weak member
-        pair<pair<double, double>, pair<vector<int>, vector<int>>> worst_member = populationFitness(population, requests, vehicleCapacity, distanceMatrix);
+        pair<pair<double, double>, pair<vector<int>, vector<int>>> worst_member = populationFitness(population, requests, fleet, distanceMatrix);
         auto worst_score = worst_member.first.first;
         auto worst_solution = worst_member.second.first;
 
-        // Evaluate the offsprings against the lowest score in population
-        auto offspring1_score = fitness(offspring1, requests, vehicleCapacity, distanceMatrix);
-        auto offspring2_score = fitness(offspring2, requests, vehicleCapacity, distanceMatrix);
-
-        double better_score = offspring1_score > offspring2_score ?  offspring2_score : offspring1_score;
-
-        // Choose the better offspring to use as a replacement (Another approach would be to use both - the better to replace the worst, then recalculate and the other replace the next worst)
-        vector<int> better_offspring = offspring1_score > offspring2_score ? offspring2 : offspring1;
-
         // Replace the worst member with offspring
-        if (better_score < worst_score) {
+        if (child.score < worst_score) {
             removeMember(population, worst_solution);
-            population.push_back(offspring1);
+            hashes.erase(chromosomeHash(worst_solution));
+            population.push_back(move(child.tour));
+            hashes.insert(child.hash);
         }
+    };
+
+    // In the generational mode the offspring of a generation are bred in parallel from the same population, each from
+    // its own random stream keyed by the generation and its index, and they join the population in the order of their
+    // index, so the search is the same for any number of threads (the operators are rewarded per call, not per CPU time)
+    // The distances of the offspring to the members are calculated in parallel too, only the distances between the
+    // offspring that join the population during the generation and the selection of the survivors are left sequential
+    size_t generationSize = options.generational ? max(options.generationSize, (size_t)1) : 1;
+    optional<ThreadPool> pool;
+    if (options.generational) {
+        pool.emplace(options.threads);
+    }
+    uint64_t seed = threadSeed();
+    size_t nextExchange = options.exchangeInterval;
+
+    // Running the algorithm
+    for (size_t i = 0, generation = 0; options.timeLimit > 0 or i < iteration_limit; generation++) {
+        if (options.timeLimit > 0 and chrono::duration<double>(chrono::steady_clock::now() - searchStart).count() >= options.timeLimit) {
+            break;
+        }
+        if (options.incumbent != nullptr and i >= nextExchange) {
+            exchangeIncumbent(population, publishedCost, requests, fleet, distanceMatrix, *options.incumbent);
+            nextExchange += options.exchangeInterval;
+            hashes.assign(population);
+            if (options.biasedFitness) {
+                diversity.assign(population);
+                for (size_t m = 0; m < population.size(); m++) {
+                    scores[m] = fitness(population[m], requests, fleet, distanceMatrix);
+                }
+            }
+        }
+
+        size_t count = options.timeLimit > 0 ? generationSize : min(generationSize, iteration_limit - i);
+        vector<Offspring> offspring(count);
+        if (pool) {
+            // the worst cost cannot grow during the generation, an offspring that is not better is never admitted,
+            // a single worker calculates the distances only for the admitted offspring as the steady-state mode does
+            bool parallelDistances = options.biasedFitness and pool->size() > 1;
+            double worstScore = parallelDistances ? *max_element(scores.begin(), scores.end()) : 0;
+            vector<exception_ptr> errors(count);
+            for (size_t k = 0; k < count; k++) {
+                pool->submit([&, k]() {
+                    try {
+                        RandomScope random(streamSeed(streamSeed(seed, generation), k));
+                        offspring[k] = breed(population, hashes, requests, fleet, distanceMatrix, operators, options.mutationRate, false);
+                        if (parallelDistances and offspring[k].score < worstScore and !hashes.contains(offspring[k].hash)) {
+                            offspring[k].adjacency.emplace(offspring[k].tour, requests.size() + 2);
+                            offspring[k].memberDistances = diversity.distancesTo(*offspring[k].adjacency);
+                        }
+                    } catch (...) {
+                        errors[k] = current_exception();
+                    }
+                });
+            }
+            pool->wait();
+            for (auto &error : errors) {
+                if (error) {
+                    rethrow_exception(error);
+                }
+            }
+        } else {
+            // only a search limited by time rewards the operators per CPU time, a search limited by the iterations
+            // rewards them per call so that the same seed gives the same solution
+            offspring[0] = breed(population, hashes, requests, fleet, distanceMatrix, operators, options.mutationRate, options.timeLimit > 0);
+        }
+        if (pool) {
+            generationStart = population.size();
+            origins.resize(generationStart);
+            iota(origins.begin(), origins.end(), 0);
+        }
+        for (size_t k = 0; k < count; k++) {
+            survive(offspring[k], k);
+        }
+        i += count;
+    }
+
+    if (options.incumbent != nullptr) {
+        exchangeIncumbent(population, publishedCost, requests, fleet, distanceMatrix, *options.incumbent);
     }
 
     // Find the best score
-    pair<pair<double, double>, pair<vector<int>, vector<int>>> best_member = populationFitness(population, requests, vehicleCapacity, distanceMatrix);
+    pair<pair<double, double>, pair<vector<int>, vector<int>>> best_member = populationFitness(population, requests, fleet, distanceMatrix);
     auto best_solution = best_member.second.second;
 
     // TIMESTAMP: record the time after the algorithm ends and calculate its duration
     auto algorithmEnd = chrono::high_resolution_clock::now();
     auto algorithmDuration = chrono::duration_cast<chrono::microseconds>(algorithmEnd - algorithmStart);
+    auto improveTime = improveTimer.elapsed();
 
     // Find the best routes
-    vector<vector<int>> routes = getRoutes(best_solution, requests, vehicleCapacity);
-
-    double vehicleCount = routes.size();
-    double routeDistance = best_member.first.second - vehicleCount; // I added number of routes as a penalty, substract it
-    double average_n_of_customers = 0;
-    double routes_linking_2 = 0;
-    double routes_linking_1 = 0;
-    double unused_capacity = 0;
-    for (auto a : routes) {
-        auto cust_n = a.size();
-
-        if (cust_n == 1) { // If there is only 1 customer on the route, icnrease the counter
-            routes_linking_1++;
-        } else if (cust_n == 2) { // If there are only 2 customers on the route, icnrease the counter
-            routes_linking_2++;
+    Solution solution;
+    solution.algorithm = "genetic";
+    if (fleet.isUniform() and !fleet.timeWindows) {
+        solution.routes = getRoutes(best_solution, requests, fleet);
+        solution.distance = best_member.first.second - solution.routes.size(); // I added number of routes as a penalty, substract it
+        if (fleet.maxVehicles >= 0 and (int)solution.routes.size() > fleet.maxVehicles) { // the score includes the excess vehicles too
+            solution.distance = 0;
+            for (auto &route : solution.routes) {
+                solution.distance += calculateCustomerDistance(route, distanceMatrix);
+            }
+        }
+    } else {
+        FleetSplit split = splitFleet(best_solution, requests, fleet, distanceMatrix, true);
+        solution.routes = split.routes;
+        solution.distance = split.distance;
+        for (auto& type : split.types) {
+            if (!fleet.isUniform()) {
+                solution.capacities.push_back(fleet.types[type].capacity);
+            }
         }
-        unused_capacity += findUnusedCapacity(a, requests, vehicleCapacity);
-        average_n_of_customers += cust_n;
     }
-    average_n_of_customers = average_n_of_customers / vehicleCount;
-
-    // Printe the routes
-    print2D(routes); 
-
-    // Overall distances
-    cout << "Overall distances: " << routeDistance << endl;
-
-    // N-of-vehicles
-    cout << "Vehicles: " << vehicleCount << endl;
-
-    // average nubmer of customers per route
-    cout << "Average number of customers: " << average_n_of_customers << endl;
-
-    // routes linking only 2 customers
-    cout << "Number of routes linking only one customer: " << routes_linking_1 << endl;
-
-    // routes linking only 2 customers
-    cout << "Number of routes linking only two customers: " << routes_linking_2 << endl;
-
-    // unused capacity in all routes
-    cout << "Unused capacity: " << unused_capacity << endl;
+    solution.algorithmTime = algorithmDuration.count();
+    solution.constructTime = constructTime;
+    solution.improveTime = improveTime;
+    solution.calculateStatistics(requests, fleet.maxCapacity());
+    fleetFitnessCache.clear(); // the problem of the run may be freed and its addresses reused by another one
 
-    // time
-    cout << "Time of the algorithm " << algorithmDuration.count() << " microseconds" << endl;
+    return solution;
 }
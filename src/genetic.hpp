@@ -2,24 +2,78 @@
 #define GENETIC_H
 
 #include "../structures/DataReader.hpp"
+#include "../structures/Solution.hpp"
+#include "distancematrix.hpp"
+#include "fleet.hpp"
+#include "incumbent.hpp"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
 #include <random>
 #include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
 
-void genetic(const vector<Node>& nodes, const vector<Request>& requests, const double &vehicleCapacity);
+const size_t SAVINGS_SEED_LIMIT = 300;       // the most customers for which the savings solution seeds the population
+const unsigned int NEAREST_NEIGHBOUR_SEEDS = 8; // randomized nearest neighbour tours seeding the population
+const size_t CLOSE_MEMBERS = 5;              // nearest members averaged for the diversity contribution of a member
+const double OPERATOR_MIN_PROBABILITY = 0.05; // every operator is still chosen with at least this probability
+const double OPERATOR_ADAPTATION_RATE = 0.05; // rate of the adaptive pursuit of the operator rewards and probabilities
+
+// Crossover of two giant tours into two children, the operators can be given to the algorithm in GeneticOptions
+struct CrossoverOperator {
+    string name;
+    function<pair<vector<int>, vector<int>>(const vector<int>&, const vector<int>&, const vector<Request>&, const Fleet&)> apply;
+};
+
+// Mutation of a giant tour
+struct MutationOperator {
+    string name;
+    function<vector<int>(const vector<int>&, const vector<Request>&, const Fleet&)> apply;
+};
+
+vector<CrossoverOperator> crossoverOperators(); // ox, pmx, erx and srex
+vector<MutationOperator> mutationOperators();   // swap (between routes), relocate and inversion
+
+struct GeneticOptions {
+    double timeLimit = 0;           // seconds of the search, 0 to stop after the iterations instead
+    size_t iterations = 50000;      // number of iterations if there is no time limit
+    size_t populationSize = 50;     // 50 seems ok
+    bool hybridPopulation = true;   // seed the population with constructive solutions, otherwise it is random
+    bool biasedFitness = true;      // survivors chosen by their cost and diversity (hybrid genetic search), otherwise the worst member is replaced
+    double diversityWeight = 0.05;  // weight of the diversity rank in the biased fitness, the cost rank has weight 1
+    size_t threads = 1;             // worker threads building the constructive solutions and breeding the generations, 0 for one per hardware thread
+    bool generational = false;      // breed generations of offspring in parallel (the same result for any number of threads), otherwise one offspring per iteration
+    size_t generationSize = 32;     // offspring bred per generation in the generational mode
+    double mutationRate = 1.0;      // probability that the offspring is mutated
+    vector<CrossoverOperator> crossovers; // operators chosen adaptively by their improvement per call (per CPU time with a time limit), empty for crossoverOperators()
+    vector<MutationOperator> mutations;   // empty for mutationOperators()
+    vector<vector<int>> initialRoutes; // previous solution seeding the population, empty for a random population
+    Incumbent* incumbent = nullptr; // best solution shared with other engines, nullptr to search alone
+    size_t exchangeInterval = 1000; // iterations between the exchanges with the incumbent
+};
+
+Solution genetic(const vector<Node>& nodes, const vector<Request>& requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix, const GeneticOptions &options = GeneticOptions());
 void removeMember(vector<vector<int>> &population, const vector<int> &to_remove);
 
-double fitness(const vector<int> &solution, const vector<Request> &requests, const double &vehicleCapacity, const vector<vector<double>> &distanceMatrix);
-double calculateCustomerDistance(const vector<int> &current_route, const vector<vector<double>> &distanceMatrix); // TODO: candidate for util
+// With a heterogeneous fleet or time windows, the fitness is cached per thread by the addresses of the requests, the fleet
+// and the matrix, they must not be modified (or freed and reused for another problem) between the calls outside of genetic()
+double fitness(const vector<int> &solution, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix);
+double calculateCustomerDistance(const vector<int> &current_route, const DistanceMatrix &distanceMatrix); // TODO: candidate for util
 
 vector<vector<int>> initPopulation(const vector<Node> &customers, const size_t &populationSize);
-vector<vector<int>> getRoutes(const vector<int> &solution, const vector<Request> &requests, const double &vehicleCapacity);
-vector<int> mutation(const vector<int> &solution, const vector<Request> &requests, const double &vehicleCapacity);
-vector<int> binaryTournament(const vector<vector<int>> &population, const vector<Request> &requests, const double &vehicleCapacity, const vector<vector<double>> &distanceMatrix);
+vector<vector<int>> hybridPopulation(const vector<Node> &customers, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix, size_t populationSize, size_t threads);
+vector<vector<int>> getRoutes(const vector<int> &solution, const vector<Request> &requests, const Fleet &fleet);
+vector<int> mutation(const vector<int> &solution, const vector<Request> &requests, const Fleet &fleet);
+vector<int> binaryTournament(const vector<vector<int>> &population, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix);
 
 pair<vector<int>, vector<int>> orderedCrossover(const vector<int> &parent1, const vector<int> &parent2);
-pair<pair<double,double>, pair<vector<int>, vector<int>>> populationFitness(const vector<vector<int>> &population, const vector<Request> &requests, const double &vehicleCapacity, const vector<vector<double>> &distanceMatrix);
+pair<vector<int>, vector<int>> partiallyMappedCrossover(const vector<int> &parent1, const vector<int> &parent2);
+pair<vector<int>, vector<int>> edgeRecombinationCrossover(const vector<int> &parent1, const vector<int> &parent2);
+pair<vector<int>, vector<int>> selectiveRouteExchange(const vector<int> &parent1, const vector<int> &parent2, const vector<Request> &requests, const Fleet &fleet);
+vector<int> relocateMutation(const vector<int> &solution);
+vector<int> inversionMutation(const vector<int> &solution);
+pair<pair<double,double>, pair<vector<int>, vector<int>>> populationFitness(const vector<vector<int>> &population, const vector<Request> &requests, const Fleet &fleet, const DistanceMatrix &distanceMatrix);
 
 #endif
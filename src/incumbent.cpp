@@ -0,0 +1,59 @@
+#include "incumbent.hpp"
+#include "genetic.hpp"
+#include "timewindows.hpp"
+
+Incumbent::Incumbent(const vector<Request>& requests, const Fleet& fleet, const DistanceMatrix& distanceMatrix)
+    : requests(requests), fleet(fleet), distanceMatrix(distanceMatrix) {
+    if (fleet.maxVehicles >= 0) {
+        vector<int> tour;
+        for (size_t customer = 2; customer <= requests.size() + 1; customer++) {
+            tour.push_back(customer);
+        }
+        vehiclePenalty = excessVehiclePenalty(tour, distanceMatrix);
+    }
+}
+
+Incumbent::~Incumbent() {
+    const IncumbentSolution* entry = head.load();
+    while (entry != nullptr) {
+        const IncumbentSolution* previous = entry->previous;
+        delete entry;
+        entry = previous;
+    }
+}
+
+double Incumbent::cost(const vector<vector<int>>& routes) const {
+    double value = 0;
+    for (auto& route : routes) {
+        value += calculateCustomerDistance(route, distanceMatrix);
+        if (fleet.timeWindows) {
+            value += TIME_WARP_PENALTY * routeTimeWarp(route, requests, fleet.horizon, distanceMatrix);
+        }
+    }
+    if (fleet.maxVehicles >= 0 and (int)routes.size() > fleet.maxVehicles) {
+        value += (routes.size() - fleet.maxVehicles) * vehiclePenalty;
+    }
+    return value;
+}
+
+bool Incumbent::offer(const vector<vector<int>>& routes, const string& source) {
+    double value = cost(routes);
+    const IncumbentSolution* current = head.load(memory_order_acquire);
+    if (current != nullptr and current->cost <= value + 1e-9) {
+        return false;
+    }
+    IncumbentSolution* entry = new IncumbentSolution{value, routes, source, current};
+    // another engine may publish in the meantime, the solution is retried against its one
+    while (!head.compare_exchange_weak(current, entry, memory_order_release, memory_order_acquire)) {
+        if (current != nullptr and current->cost <= value + 1e-9) {
+            delete entry;
+            return false;
+        }
+        entry->previous = current;
+    }
+    return true;
+}
+
+const IncumbentSolution* Incumbent::best() const {
+    return head.load(memory_order_acquire);
+}
@@ -0,0 +1,78 @@
+/**
+ * Best solution shared by search engines running in parallel
+ * The engines publish their improvements and read the best solution found by any of them without a lock. Every
+ * published solution is an immutable entry linked to the previous best one and the head of the list is swapped
+ * by compare-and-swap, so a reader never sees a half-written solution. The entries are freed only with the
+ * incumbent, every one of them is strictly better than the previous, so there are few of them.
+**/
+
+#ifndef INCUMBENT_HPP
+#define INCUMBENT_HPP
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "../structures/Request.hpp"
+#include "distancematrix.hpp"
+#include "fleet.hpp"
+
+using namespace std;
+
+struct IncumbentSolution {
+    double cost;                  // see Incumbent::cost()
+    vector<vector<int>> routes;   // customer IDs of the routes (without the depot), built for the largest vehicle
+    string source;                // the engine that found the solution
+    const IncumbentSolution* previous; // the solution it replaced
+};
+
+class Incumbent {
+private:
+    atomic<const IncumbentSolution*> head{nullptr};
+    const vector<Request>& requests;
+    const Fleet& fleet;
+    const DistanceMatrix& distanceMatrix;
+    double vehiclePenalty = 0;
+
+public:
+    /**
+     * Creates an empty incumbent of the problem.
+     * @param requests requests of the customers, customer with ID i has the request i-2
+     * @param fleet the available vehicles
+     * @param distanceMatrix distances between all nodes
+     */
+    Incumbent(const vector<Request>& requests, const Fleet& fleet, const DistanceMatrix& distanceMatrix);
+
+    /**
+     * Frees all published solutions, no engine may use them any more.
+     */
+    ~Incumbent();
+
+    Incumbent(const Incumbent&) = delete;
+    Incumbent& operator=(const Incumbent&) = delete;
+
+    /**
+     * Calculates the cost the engines are compared by: the distance, the time warp (weighted by TIME_WARP_PENALTY)
+     * and the vehicles over the limit (weighted by excessVehiclePenalty()).
+     * Time complexity: O(n)
+     * @param routes customer IDs of the routes (without the depot)
+     * @return the cost
+     */
+    double cost(const vector<vector<int>>& routes) const;
+
+    /**
+     * Publishes the solution if it is better than the best one.
+     * Time complexity: O(n), the solution is copied only if it is better
+     * @param routes customer IDs of the routes (without the depot), every route fits the largest vehicle
+     * @param source name of the engine
+     * @return true if the solution became the best one
+     */
+    bool offer(const vector<vector<int>>& routes, const string& source);
+
+    /**
+     * Retrieves the best published solution, it stays valid as long as the incumbent exists.
+     * @return the best solution or nullptr if nothing was published yet
+     */
+    const IncumbentSolution* best() const;
+};
+
+#endif //INCUMBENT_HPP
@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <optional>
+#include "lns.hpp"
+#include "random.hpp"
+#include "savings.hpp"
+#include "timewindows.hpp"
+#include "timing.hpp"
+
+static const size_t NEIGHBOURS = 100; // nearest customers of every customer considered by the ruin
+
+/**
+ * Function to get a random number in [0, 1), every thread has its own generator (see random.hpp)
+*/
+static double randomUnit() {
+    return threadRandom().unit();
+}
+
+/**
+ * Function to get a random integer in [from, to]
+*/
+static int randomInt(int from, int to) {
+    return from + (int)(randomUnit() * (to - from + 1));
+}
+
+namespace {
+    // Route of the search with its load, distance and timing cached for the evaluation of the insertions
+    struct LnsRoute {
+        vector<int> customers;
+        double load = 0;
+        double distance = 0;
+        double timeWarp = 0;
+        optional<RouteTimeWindows> timing; // only with time windows
+    };
+
+    struct LnsState {
+        vector<LnsRoute> routes;
+        double cost = 0; // distance plus the penalized time warp
+    };
+
+    struct LnsContext {
+        const vector<Request>& requests;
+        const Fleet& fleet;
+        const DistanceMatrix& distanceMatrix;
+        const LnsOptions& options;
+        vector<vector<int>> neighbours; // the nearest customers of every customer (by ID)
+        double capacity;
+    };
+}
+
+// Recalculates the cached values of the route after it was modified
+static void refresh(LnsRoute& route, const LnsContext& context) {
+    auto& matrix = context.distanceMatrix;
+    route.load = 0;
+    route.distance = 0;
+    int previous = 0;
+    for (auto& customer : route.customers) {
+        route.load += context.requests[customer-2].quantity; // customer with ID 2 has the request n. 0
+        route.distance += matrix[previous][customer-1];
+        previous = customer - 1;
+    }
+    route.distance += matrix[previous][0];
+    if (context.fleet.timeWindows) {
+        route.timing.emplace(route.customers, context.requests, context.fleet.horizon, matrix);
+        route.timeWarp = route.timing->timeWarp();
+    }
+}
+
+static double stateCost(const LnsState& state) {
+    double cost = 0;
+    for (auto& route : state.routes) {
+        cost += route.distance + route.timeWarp * TIME_WARP_PENALTY;
+    }
+    return cost;
+}
+
+// Builds the state of the search from the routes
+static LnsState makeState(const vector<vector<int>>& routes, const LnsContext& context) {
+    LnsState state;
+    for (auto& customers : routes) {
+        LnsRoute route;
+        route.customers = customers;
+        refresh(route, context);
+        state.routes.push_back(route);
+    }
+    state.cost = stateCost(state);
+    return state;
+}
+
+// Customers of the non-empty routes of the state
+static vector<vector<int>> routesOf(const LnsState& state) {
+    vector<vector<int>> routes;
+    for (auto& route : state.routes) {
+        if (!route.customers.empty()) {
+            routes.push_back(route.customers);
+        }
+    }
+    return routes;
+}
+
+/**
+ * Removes strings of customers from routes close to a random customer (SISR), or with a smaller probability
+ * all customers close to it (radial ruin)
+ * Time complexity: O(n)
+ * Space complexity: O(n)
+*/
+static vector<int> ruin(LnsState& state, const LnsContext& context) {
+    size_t customers = 0;
+    vector<int> routeOf(context.requests.size() + 2, -1);
+    for (size_t r = 0; r < state.routes.size(); r++) {
+        for (auto& customer : state.routes[r].customers) {
+            routeOf[customer] = r;
+        }
+        customers += state.routes[r].customers.size();
+    }
+    vector<bool> removed(context.requests.size() + 2, false);
+    vector<int> removedCustomers;
+    int seed = randomInt(2, customers + 1);
+    auto& neighbours = context.neighbours[seed];
+
+    if (randomUnit() < 1.0 / 3) {
+        // radial ruin, the seed and its nearest customers
+        size_t count = min((size_t)randomInt(1, 2 * context.options.averageRemoved), neighbours.size() + 1);
+        removedCustomers.push_back(seed);
+        removedCustomers.insert(removedCustomers.end(), neighbours.begin(), neighbours.begin() + count - 1);
+        for (auto& customer : removedCustomers) {
+            removed[customer] = true;
+        }
+    } else {
+        // string removal, strings of the routes visited in the order of the distance from the seed
+        double averageRoute = (double)customers / state.routes.size();
+        double maxLength = min(context.options.maxStringLength, averageRoute);
+        double maxStrings = 4 * context.options.averageRemoved / (1 + maxLength) - 1;
+        size_t strings = floor(randomUnit() * maxStrings) + 1;
+        vector<bool> ruined(state.routes.size(), false);
+        size_t ruinedCount = 0;
+        for (size_t k = 0; k <= neighbours.size() and ruinedCount < strings; k++) {
+            int customer = k == 0 ? seed : neighbours[k-1];
+            int r = routeOf[customer];
+            if (removed[customer] or ruined[r]) {
+                continue;
+            }
+            auto& route = state.routes[r].customers;
+            int size = route.size();
+            int position = find(route.begin(), route.end(), customer) - route.begin();
+            int length = randomInt(1, min((int)maxLength, size));
+            int preserved = 0;
+            if (length < size and randomUnit() < 0.5) {
+                // split string, a random part in the middle of the string stays in the route
+                preserved = 1;
+                while (length + preserved < size and randomUnit() < 0.5) {
+                    preserved++;
+                }
+            }
+            int span = length + preserved;
+            int start = randomInt(max(0, position - span + 1), min(position, size - span));
+            int keepFrom = start + randomInt(0, length);
+            for (int i = start; i < start + span; i++) {
+                if (i >= keepFrom and i < keepFrom + preserved) {
+                    continue;
+                }
+                removed[route[i]] = true;
+                removedCustomers.push_back(route[i]);
+            }
+            ruined[r] = true;
+            ruinedCount++;
+        }
+    }
+
+    for (auto& route : state.routes) {
+        size_t before = route.customers.size();
+        route.customers.erase(remove_if(route.customers.begin(), route.customers.end(),
+                                        [&](int customer) { return removed[customer]; }), route.customers.end());
+        if (route.customers.size() != before) {
+            refresh(route, context);
+        }
+    }
+    state.routes.erase(remove_if(state.routes.begin(), state.routes.end(),
+                                 [](const LnsRoute& route) { return route.customers.empty(); }), state.routes.end());
+    return removedCustomers;
+}
+
+/**
+ * Inserts the removed customers back, each at the cheapest position where it fits, some positions are skipped
+ * (blinks) to diversify the search
+ * Time complexity: O(c * n) for c removed customers, a position is evaluated in O(1) from the cached route values
+ * Space complexity: O(1)
+*/
+static void recreate(LnsState& state, vector<int>& removed, const LnsContext& context) {
+    auto& matrix = context.distanceMatrix;
+    auto& requests = context.requests;
+    // the order of the insertions is chosen randomly as in SISR (random, demand, far and close to the depot)
+    double order = randomUnit() * 11;
+    if (order < 4) {
+        shuffle(removed.begin(), removed.end(), threadRandom());
+    } else if (order < 8) {
+        sort(removed.begin(), removed.end(), [&](int a, int b) { return requests[a-2].quantity > requests[b-2].quantity; });
+    } else if (order < 10) {
+        sort(removed.begin(), removed.end(), [&](int a, int b) { return matrix[0][a-1] > matrix[0][b-1]; });
+    } else {
+        sort(removed.begin(), removed.end(), [&](int a, int b) { return matrix[0][a-1] < matrix[0][b-1]; });
+    }
+
+    for (auto& customer : removed) {
+        double demand = requests[customer-2].quantity;
+        int c = customer - 1;
+        double bestCost = numeric_limits<double>::infinity();
+        int bestRoute = -1;
+        size_t bestPosition = 0;
+        for (size_t r = 0; r < state.routes.size(); r++) {
+            auto& route = state.routes[r];
+            if (route.load + demand > context.capacity) {
+                continue;
+            }
+            for (size_t position = 0; position <= route.customers.size(); position++) {
+                if (randomUnit() < context.options.blinkRate) {
+                    continue;
+                }
+                int before = position == 0 ? 0 : route.customers[position-1] - 1;
+                int after = position == route.customers.size() ? 0 : route.customers[position] - 1;
+                double cost = matrix[before][c] + matrix[c][after] - matrix[before][after];
+                if (route.timing) {
+                    cost += (route.timing->insertionTimeWarp(position, customer) - route.timeWarp) * TIME_WARP_PENALTY;
+                }
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestRoute = r;
+                    bestPosition = position;
+                }
+            }
+        }
+        // a new route is opened if it is cheaper, unless all vehicles are already used
+        bool vehicleLeft = context.fleet.maxVehicles < 0 or (int)state.routes.size() < context.fleet.maxVehicles;
+        if (bestRoute == -1 or (vehicleLeft and matrix[0][c] + matrix[c][0] < bestCost)) {
+            state.routes.push_back(LnsRoute());
+            bestRoute = state.routes.size() - 1;
+            bestPosition = 0;
+        }
+        auto& route = state.routes[bestRoute];
+        route.customers.insert(route.customers.begin() + bestPosition, customer);
+        refresh(route, context);
+    }
+}
+
+Solution lns(const vector<Node>& nodes, const vector<Request>& requests, const Fleet& fleet,
+             const DistanceMatrix& distanceMatrix, const LnsOptions& options) {
+    // TIMESTAMP: Record time before the algorithm starts
+    auto algorithmStart = chrono::high_resolution_clock::now();
+
+    PhaseTimer constructTimer;
+    LnsContext context{requests, fleet, distanceMatrix, options, vector<vector<int>>(nodes.size() + 1), fleet.maxCapacity()};
+    for (size_t customer = 2; customer <= nodes.size(); customer++) {
+        auto& neighbours = context.neighbours[customer];
+        for (size_t other = 2; other <= nodes.size(); other++) {
+            if (other != customer) {
+                neighbours.push_back(other);
+            }
+        }
+        size_t count = min(NEIGHBOURS, neighbours.size());
+        partial_sort(neighbours.begin(), neighbours.begin() + count, neighbours.end(), [&](int a, int b) {
+            return distanceMatrix[customer-1][a-1] < distanceMatrix[customer-1][b-1];
+        });
+        neighbours.resize(count);
+    }
+
+    // The savings solution is the starting point, unless an initial solution is given or another engine has
+    // already published a solution
+    const IncumbentSolution* shared = options.incumbent != nullptr ? options.incumbent->best() : nullptr;
+    LnsState current = makeState(shared != nullptr ? shared->routes
+                                 : !options.initialRoutes.empty() ? options.initialRoutes
+                                 : savingsAlgorithm(nodes, requests, fleet, distanceMatrix).routes,
+                                 context);
+    LnsState best = current;
+    double publishedCost = shared != nullptr ? shared->cost : numeric_limits<double>::infinity();
+    auto constructTime = constructTimer.elapsed();
+
+    // The temperature falls exponentially from the length of an average edge to a hundredth of it
+    PhaseTimer improveTimer;
+    double averageEdge = current.cost / (nodes.size() - 1 + current.routes.size());
+    double initialTemperature = averageEdge;
+    double finalTemperature = averageEdge / 100;
+    auto searchStart = chrono::steady_clock::now();
+    for (size_t iteration = 0; ; iteration++) {
+        double progress;
+        if (options.timeLimit > 0) {
+            progress = chrono::duration<double>(chrono::steady_clock::now() - searchStart).count() / options.timeLimit;
+        } else {
+            progress = (double)iteration / options.iterations;
+        }
+        if (progress >= 1) {
+            break;
+        }
+        double temperature = initialTemperature * pow(finalTemperature / initialTemperature, progress);
+
+        LnsState candidate = current;
+        vector<int> removed = ruin(candidate, context);
+        recreate(candidate, removed, context);
+        candidate.cost = stateCost(candidate);
+
+        if (candidate.cost < current.cost - temperature * log(randomUnit() + 1e-300)) {
+            current = move(candidate);
+            if (current.cost < best.cost) {
+                best = current;
+            }
+        }
+
+        if (options.incumbent != nullptr and iteration % options.exchangeInterval == 0) {
+            // the improvement is published, the search continues from a better solution of another engine
+            vector<vector<int>> routes = routesOf(best);
+            double cost = options.incumbent->cost(routes);
+            if (cost < publishedCost - 1e-9) {
+                options.incumbent->offer(routes, "lns");
+                publishedCost = cost;
+            }
+            shared = options.incumbent->best();
+            if (shared != nullptr and shared->cost < publishedCost - 1e-9) {
+                current = makeState(shared->routes, context);
+                best = current;
+                publishedCost = shared->cost;
+            }
+        }
+    }
+    if (options.incumbent != nullptr) {
+        options.incumbent->offer(routesOf(best), "lns");
+    }
+    auto improveTime = improveTimer.elapsed();
+
+    // TIMESTAMP: record the time after the algorithm ends and calculate its duration
+    auto algorithmEnd = chrono::high_resolution_clock::now();
+    auto algorithmDuration = chrono::duration_cast<chrono::microseconds>(algorithmEnd - algorithmStart);
+
+    Solution solution;
+    solution.algorithm = "lns";
+    assignVehicles(solution, routesOf(best), requests, fleet, distanceMatrix);
+    solution.algorithmTime = algorithmDuration.count();
+    solution.constructTime = constructTime;
+    solution.improveTime = improveTime;
+    solution.calculateStatistics(requests, fleet.maxCapacity());
+
+    return solution;
+}
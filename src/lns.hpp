@@ -0,0 +1,49 @@
+/**
+ * Ruin and recreate large neighbourhood search
+ * Based on the slack induction by string removals (SISR) of Christiaens and Vanden Berghe, A fresh ruin & recreate
+ * implementation for the capacitated vehicle routing problem, 2020. Every iteration removes a few strings of
+ * customers from routes close to each other (or all customers around a random one), inserts them back greedily
+ * with blinks (randomly skipped positions) and accepts the result with the simulated annealing criterion.
+ * The savings solution (or the given initial solution) is the starting point. With a shared incumbent (the
+ * portfolio) the search starts from it, publishes its best solution every few iterations and continues from the
+ * incumbent when another engine found a better one.
+**/
+
+#ifndef LNS_HPP
+#define LNS_HPP
+
+#include "../structures/DataReader.hpp"
+#include "../structures/Solution.hpp"
+#include "distancematrix.hpp"
+#include "fleet.hpp"
+#include "incumbent.hpp"
+
+using namespace std;
+
+struct LnsOptions {
+    double timeLimit = 0;           // seconds of the search, 0 to stop after the iterations instead
+    size_t iterations = 30000;      // number of iterations if there is no time limit
+    double averageRemoved = 10;     // average number of removed customers (c in the paper)
+    double maxStringLength = 10;    // the longest removed string (L_max in the paper)
+    double blinkRate = 0.01;        // probability of skipping a position during the insertion
+    vector<vector<int>> initialRoutes; // starting solution instead of the savings one, it must be feasible
+    Incumbent* incumbent = nullptr; // best solution shared with other engines, nullptr to search alone
+    size_t exchangeInterval = 500;  // iterations between the exchanges with the incumbent
+};
+
+/**
+ * Runs the large neighbourhood search.
+ * Time complexity: O(i * c * n) for i iterations, c removed customers and n customers (each insertion scans
+ *                  all positions, the loads and distances of the routes are cached so a position costs O(1))
+ * Space complexity: O(n * K) for the K nearest neighbours of every customer
+ * @param nodes nodes of the problem, the depot first
+ * @param requests requests of the customers, customer with ID i has the request i-2
+ * @param fleet the available vehicles (routes are built for the largest one, the smallest that fits is assigned)
+ * @param distanceMatrix distances between all nodes
+ * @param options parameters of the search
+ * @return the best solution found
+ */
+Solution lns(const vector<Node>& nodes, const vector<Request>& requests, const Fleet& fleet,
+             const DistanceMatrix& distanceMatrix, const LnsOptions& options = LnsOptions());
+
+#endif //LNS_HPP
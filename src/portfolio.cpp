@@ -0,0 +1,86 @@
+#include <chrono>
+#include <exception>
+#include <functional>
+#include "portfolio.hpp"
+#include "genetic.hpp"
+#include "incumbent.hpp"
+#include "lns.hpp"
+#include "random.hpp"
+#include "savings.hpp"
+#include "tabu.hpp"
+#include "threadpool.hpp"
+#include "timing.hpp"
+
+Solution portfolio(const vector<Node>& nodes, const vector<Request>& requests, const Fleet& fleet,
+                   const DistanceMatrix& distanceMatrix, const PortfolioOptions& options) {
+    // TIMESTAMP: Record time before the algorithm starts
+    auto algorithmStart = chrono::high_resolution_clock::now();
+    auto runStart = chrono::steady_clock::now();
+
+    // The savings solution (unless an initial one is given) is ready almost at once and every engine starts from it
+    PhaseTimer constructTimer;
+    Incumbent incumbent(requests, fleet, distanceMatrix);
+    if (!options.initialRoutes.empty()) {
+        incumbent.offer(options.initialRoutes, "initial");
+    } else {
+        incumbent.offer(savingsAlgorithm(nodes, requests, fleet, distanceMatrix).routes, "savings");
+    }
+    auto constructTime = constructTimer.elapsed();
+
+    // The engines share the rest of the time limit
+    PhaseTimer improveTimer;
+    double remaining = options.timeLimit - chrono::duration<double>(chrono::steady_clock::now() - runStart).count();
+    if (options.timeLimit <= 0 or remaining > 0) {
+        GeneticOptions geneticOptions;
+        geneticOptions.timeLimit = options.timeLimit > 0 ? remaining : 0;
+        geneticOptions.incumbent = &incumbent;
+        LnsOptions lnsOptions;
+        lnsOptions.timeLimit = geneticOptions.timeLimit;
+        lnsOptions.incumbent = &incumbent;
+        TabuOptions tabuOptions;
+        tabuOptions.timeLimit = geneticOptions.timeLimit;
+        tabuOptions.incumbent = &incumbent;
+        vector<function<void()>> engines = {
+            [&]() { genetic(nodes, requests, fleet, distanceMatrix, geneticOptions); },
+            [&]() { lns(nodes, requests, fleet, distanceMatrix, lnsOptions); },
+            [&]() { tabuSearch(nodes, requests, fleet, distanceMatrix, tabuOptions); },
+        };
+        vector<exception_ptr> errors(engines.size());
+        uint64_t seed = threadSeed(); // every engine has its own stream, whichever thread runs it
+        {
+            ThreadPool pool(engines.size());
+            for (size_t e = 0; e < engines.size(); e++) {
+                pool.submit([&, e]() {
+                    try {
+                        RandomScope random(streamSeed(seed, e));
+                        engines[e]();
+                    } catch (...) {
+                        errors[e] = current_exception();
+                    }
+                });
+            }
+            pool.wait();
+        }
+        for (auto& error : errors) {
+            if (error) {
+                rethrow_exception(error);
+            }
+        }
+    }
+    auto improveTime = improveTimer.elapsed();
+
+    // TIMESTAMP: record the time after the algorithm ends and calculate its duration
+    auto algorithmEnd = chrono::high_resolution_clock::now();
+    auto algorithmDuration = chrono::duration_cast<chrono::microseconds>(algorithmEnd - algorithmStart);
+
+    const IncumbentSolution* best = incumbent.best();
+    Solution solution;
+    solution.algorithm = "portfolio";
+    assignVehicles(solution, best->routes, requests, fleet, distanceMatrix);
+    solution.algorithmTime = algorithmDuration.count();
+    solution.constructTime = constructTime;
+    solution.improveTime = improveTime;
+    solution.calculateStatistics(requests, fleet.maxCapacity());
+
+    return solution;
+}
@@ -0,0 +1,38 @@
+/**
+ * Portfolio of algorithms solving the problem at once
+ * The savings solution (or the given initial solution) is published to the shared incumbent first, then the genetic
+ * algorithm, the large neighbourhood search and the tabu search run on their own threads until the common time
+ * limit. They start from the incumbent, publish their improvements to it and continue from it whenever another
+ * engine found a better solution, so the fast convergence of one engine and the long improvement of another add up.
+**/
+
+#ifndef PORTFOLIO_HPP
+#define PORTFOLIO_HPP
+
+#include "../structures/DataReader.hpp"
+#include "../structures/Solution.hpp"
+#include "distancematrix.hpp"
+#include "fleet.hpp"
+
+using namespace std;
+
+struct PortfolioOptions {
+    double timeLimit = 0; // seconds of the whole run, 0 to let every engine run its fixed number of iterations
+    vector<vector<int>> initialRoutes; // starting solution instead of the savings one, it must be feasible
+};
+
+/**
+ * Runs the portfolio, one thread per engine.
+ * Time complexity: the savings algorithm and then the slowest engine (or the time limit)
+ * Space complexity: the sum of the engines and the solutions published to the incumbent
+ * @param nodes nodes of the problem, the depot first
+ * @param requests requests of the customers, customer with ID i has the request i-2
+ * @param fleet the available vehicles (routes are built for the largest one, then split for the fleet)
+ * @param distanceMatrix distances between all nodes
+ * @param options parameters of the portfolio
+ * @return the best solution of all engines
+ */
+Solution portfolio(const vector<Node>& nodes, const vector<Request>& requests, const Fleet& fleet,
+                   const DistanceMatrix& distanceMatrix, const PortfolioOptions& options = PortfolioOptions());
+
+#endif //PORTFOLIO_HPP
@@ -0,0 +1,60 @@
+#include "random.hpp"
+
+static uint64_t splitmix64(uint64_t &x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+Random::Random(uint64_t seed) {
+    for (auto& word : state) {
+        word = splitmix64(seed);
+    }
+}
+
+Random::result_type Random::operator()() {
+    uint64_t result = rotl(state[1] * 5, 7) * 9;
+    uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+}
+
+double Random::unit() {
+    return ((*this)() >> 11) * 0x1.0p-53;
+}
+
+uint64_t streamSeed(uint64_t seed, uint64_t stream) {
+    uint64_t x = seed ^ splitmix64(stream);
+    return splitmix64(x);
+}
+
+static thread_local Random generator;
+static thread_local uint64_t generatorSeed = 0;
+
+Random& threadRandom() {
+    return generator;
+}
+
+uint64_t threadSeed() {
+    return generatorSeed;
+}
+
+RandomScope::RandomScope(uint64_t seed) : previous(generator), previousSeed(generatorSeed) {
+    generator = Random(seed);
+    generatorSeed = seed;
+}
+
+RandomScope::~RandomScope() {
+    generator = previous;
+    generatorSeed = previousSeed;
+}
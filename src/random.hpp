@@ -0,0 +1,83 @@
+/**
+ * Seedable random numbers of the algorithms
+ * Every thread has its own xoshiro256** generator, so no state is shared or locked between the threads. A solve
+ * reseeds the generator of its thread from the seed of the options for its duration (see RandomScope) and the tasks
+ * it runs in parallel get their own streams derived from that seed and the index of the task, never from the thread
+ * that happens to run them, so the same seed gives the same solution however the tasks are scheduled. Only a search
+ * stopped by a time limit depends on the timing, as it does as many iterations as it manages.
+**/
+
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstdint>
+
+using namespace std;
+
+// xoshiro256** generator, it can be used with the <random> distributions and shuffle()
+class Random {
+private:
+    uint64_t state[4];
+
+public:
+    using result_type = uint64_t;
+
+    /**
+     * Seeds the generator, the state is filled by splitmix64 of the seed so that close seeds give unrelated streams.
+     * @param seed the seed
+     */
+    explicit Random(uint64_t seed = 0);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~0ULL; }
+
+    /**
+     * Generates the next number.
+     * Time complexity: O(1)
+     * @return uniformly distributed 64-bit number
+     */
+    result_type operator()();
+
+    /**
+     * Generates a number uniformly distributed between 0 (inclusive) and 1 (exclusive).
+     * @return the number with 53 random bits
+     */
+    double unit();
+};
+
+/**
+ * Derives the seed of a stream from the seed, different streams of the same seed are independent.
+ * @param seed the seed of the solve
+ * @param stream index of the stream (e.g. of the parallel task)
+ * @return the seed of the stream
+ */
+uint64_t streamSeed(uint64_t seed, uint64_t stream);
+
+/**
+ * Retrieves the generator of the calling thread, seeded by the innermost RandomScope of the thread (0 without one).
+ * @return the generator
+ */
+Random& threadRandom();
+
+/**
+ * Retrieves the seed of the innermost RandomScope of the calling thread, the parallel tasks derive their streams
+ * from it.
+ * @return the seed, 0 without a scope
+ */
+uint64_t threadSeed();
+
+// Reseeds the generator of the calling thread until the end of the scope, then the previous generator continues
+class RandomScope {
+private:
+    Random previous;
+    uint64_t previousSeed;
+
+public:
+    explicit RandomScope(uint64_t seed);
+    ~RandomScope();
+
+    RandomScope(const RandomScope&) = delete;
+    RandomScope& operator=(const RandomScope&) = delete;
+};
+
+#endif //RANDOM_HPP
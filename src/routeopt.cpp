@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include "routeopt.hpp"
+#include "genetic.hpp"
+#include "timewindows.hpp"
+
+// The tables of the Held-Karp algorithm of the thread, they only grow so the allocation happens once
+static thread_local vector<double> heldKarpCost;
+static thread_local vector<uint8_t> heldKarpParent;
+
+double heldKarp(vector<int>& route, const DistanceMatrix& distanceMatrix) {
+    size_t n = route.size();
+    if (n < 2) {
+        return n == 0 ? 0 : calculateCustomerDistance(route, distanceMatrix);
+    }
+    size_t subsets = (size_t)1 << n;
+    if (heldKarpCost.size() < subsets * n) {
+        heldKarpCost.resize(subsets * n);
+        heldKarpParent.resize(subsets * n);
+    }
+    double* cost = heldKarpCost.data();      // cost[subset * n + j] the shortest path from the depot through
+    uint8_t* parent = heldKarpParent.data(); // the subset ending in its customer j, parent is the customer before j
+    const double infinity = numeric_limits<double>::infinity();
+
+    for (size_t subset = 1; subset < subsets; subset++) {
+        for (size_t j = 0; j < n; j++) {
+            double& best = cost[subset * n + j];
+            if (!(subset & ((size_t)1 << j))) {
+                best = infinity;
+                continue;
+            }
+            size_t previous = subset ^ ((size_t)1 << j);
+            if (previous == 0) {
+                best = distanceMatrix[0][route[j]-1];
+                parent[subset * n + j] = j;
+                continue;
+            }
+            best = infinity;
+            for (size_t i = 0; i < n; i++) {
+                if (previous & ((size_t)1 << i)) {
+                    double candidate = cost[previous * n + i] + distanceMatrix[route[i]-1][route[j]-1];
+                    if (candidate < best) {
+                        best = candidate;
+                        parent[subset * n + j] = i;
+                    }
+                }
+            }
+        }
+    }
+
+    size_t all = subsets - 1;
+    size_t last = 0;
+    double shortest = infinity;
+    for (size_t j = 0; j < n; j++) {
+        double candidate = cost[all * n + j] + distanceMatrix[route[j]-1][0];
+        if (candidate < shortest) {
+            shortest = candidate;
+            last = j;
+        }
+    }
+    vector<int> order(n);
+    for (size_t subset = all, position = n; position-- > 0;) {
+        order[position] = route[last];
+        size_t before = parent[subset * n + last];
+        subset ^= (size_t)1 << last;
+        last = before;
+    }
+    route = order;
+    return shortest;
+}
+
+double localSearchRoute(vector<int>& route, const DistanceMatrix& distanceMatrix) {
+    int n = route.size();
+    if (n == 0) {
+        return 0;
+    }
+    // matrix index of the node at the position, the depot before the first and after the last customer
+    auto node = [&](int position) { return position < 0 or position >= n ? 0 : route[position] - 1; };
+    double distance = calculateCustomerDistance(route, distanceMatrix);
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        // 2-opt, the customers from i to j are visited in the reverse order
+        for (int i = 0; i < n - 1; i++) {
+            for (int j = i + 1; j < n; j++) {
+                int before = node(i - 1), first = node(i), last = node(j), after = node(j + 1);
+                double delta = distanceMatrix[before][last] + distanceMatrix[first][after]
+                               - distanceMatrix[before][first] - distanceMatrix[last][after];
+                if (delta < -1e-9) {
+                    reverse(route.begin() + i, route.begin() + j + 1);
+                    // the delta assumes symmetric distances, the reversed part is checked in full
+                    double reversed = calculateCustomerDistance(route, distanceMatrix);
+                    if (reversed < distance - 1e-9) {
+                        distance = reversed;
+                        improved = true;
+                    } else {
+                        reverse(route.begin() + i, route.begin() + j + 1);
+                    }
+                }
+            }
+        }
+        // Or-opt, the customers from i to i+length-1 are moved between the positions j-1 and j
+        for (int length = 1; length <= 3; length++) {
+            for (int i = 0; i + length <= n; i++) {
+                int before = node(i - 1), first = node(i), last = node(i + length - 1), after = node(i + length);
+                double removal = distanceMatrix[before][after] - distanceMatrix[before][first] - distanceMatrix[last][after];
+                for (int j = 0; j <= n; j++) {
+                    if (j >= i and j <= i + length) {
+                        continue; // the part would stay in its place
+                    }
+                    int previous = node(j - 1), next = node(j);
+                    double delta = removal + distanceMatrix[previous][first] + distanceMatrix[last][next]
+                                   - distanceMatrix[previous][next];
+                    if (delta < -1e-9) {
+                        vector<int> part(route.begin() + i, route.begin() + i + length);
+                        route.erase(route.begin() + i, route.begin() + i + length);
+                        int target = j > i ? j - length : j;
+                        route.insert(route.begin() + target, part.begin(), part.end());
+                        distance += delta;
+                        improved = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return calculateCustomerDistance(route, distanceMatrix);
+}
+
+double optimizeRoute(vector<int>& route, const DistanceMatrix& distanceMatrix) {
+    if (route.size() <= EXACT_ROUTE_LIMIT) {
+        return heldKarp(route, distanceMatrix);
+    }
+    return localSearchRoute(route, distanceMatrix);
+}
+
+void optimizeRoutes(Solution& solution, const vector<Request>& requests, const Fleet& fleet,
+                    const DistanceMatrix& distanceMatrix) {
+    solution.distance = 0;
+    for (auto& route : solution.routes) {
+        double distance = calculateCustomerDistance(route, distanceMatrix);
+        vector<int> optimized = route;
+        double optimizedDistance = optimizeRoute(optimized, distanceMatrix);
+        bool better = optimizedDistance < distance - 1e-9;
+        if (better and fleet.timeWindows) {
+            better = routeTimeWarp(optimized, requests, fleet.horizon, distanceMatrix)
+                     <= routeTimeWarp(route, requests, fleet.horizon, distanceMatrix);
+        }
+        if (better) {
+            route = optimized;
+            distance = optimizedDistance;
+        }
+        solution.distance += distance;
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ * Optimization of the order of the customers of single routes
+ * A route with a few customers is a small travelling salesman problem, up to EXACT_ROUTE_LIMIT customers it is
+ * solved exactly by the Held-Karp dynamic programming over the subsets of the customers (the tables are kept
+ * per thread and reused), longer routes are improved by 2-opt and Or-opt moves until no move helps.
+ * The customers of the routes do not change, so neither do the loads.
+**/
+
+#ifndef ROUTEOPT_HPP
+#define ROUTEOPT_HPP
+
+#include <vector>
+#include "../structures/Request.hpp"
+#include "../structures/Solution.hpp"
+#include "distancematrix.hpp"
+#include "fleet.hpp"
+
+using namespace std;
+
+// The longest route solved exactly, the table has 2^n * n entries
+const size_t EXACT_ROUTE_LIMIT = 12;
+
+/**
+ * Finds the shortest order of the customers of the route by the Held-Karp algorithm.
+ * Time complexity: O(2^n * n^2)
+ * Space complexity: O(2^n * n), the table of the calling thread is reused by its next calls
+ * @param route customer IDs of the route (without the depot), reordered in place
+ * @param distanceMatrix distances between all nodes (may be asymmetric)
+ * @return the distance of the optimal route
+ */
+double heldKarp(vector<int>& route, const DistanceMatrix& distanceMatrix);
+
+/**
+ * Improves the order of the customers of the route by 2-opt (reversal of a part) and Or-opt (move of a part
+ * of up to 3 customers) until neither of them shortens the route.
+ * Time complexity: O(n^2) per pass over all moves
+ * Space complexity: O(1)
+ * @param route customer IDs of the route (without the depot), reordered in place
+ * @param distanceMatrix distances between all nodes
+ * @return the distance of the improved route
+ */
+double localSearchRoute(vector<int>& route, const DistanceMatrix& distanceMatrix);
+
+/**
+ * Optimizes the order of the customers of the route, exactly if it is short enough.
+ * @param route customer IDs of the route (without the depot), reordered in place
+ * @param distanceMatrix distances between all nodes
+ * @return the distance of the route
+ */
+double optimizeRoute(vector<int>& route, const DistanceMatrix& distanceMatrix);
+
+/**
+ * Optimizes every route of the solution, the distance of the solution is updated. With time windows a new order
+ * is kept only if it does not increase the time warp of the route.
+ * Time complexity: O(r * 2^L * L^2) for r routes of at most L <= EXACT_ROUTE_LIMIT customers
+ * @param solution the solution whose routes are reordered
+ * @param requests requests of the customers, customer with ID i has the request i-2
+ * @param fleet the vehicles of the solution (their horizon and whether the time windows apply)
+ * @param distanceMatrix distances between all nodes
+ */
+void optimizeRoutes(Solution& solution, const vector<Request>& requests, const Fleet& fleet,
+                    const DistanceMatrix& distanceMatrix);
+
+#endif //ROUTEOPT_HPP
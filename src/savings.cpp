@@ -10,8 +10,10 @@
 #include <iomanip>
 #include "savings.hpp"
 #include "util.hpp"
+#include "timing.hpp"
 
-void savingsAlgorithm(const vector<Node>& nodes, const vector<Request>& requests, double vehicleCapacity) {
+Solution savingsAlgorithm(const vector<Node>& nodes, const vector<Request>& requests, const Fleet& fleet,
+                          const DistanceMatrix& distanceMatrix) {
     // TIMESTAMP: Record time before the algorithm starts
     auto algorithmStart = chrono::high_resolution_clock::now();
 
@@ -19,6 +21,13 @@ void savingsAlgorithm(const vector<Node>& nodes, const vector<Request>& requests
     int maxRoutesCnt = ceil((int) nodes.size()/2);
     multiset<Savings, SavingsRanker> savings;
     vector<bool> customersServed(nodes.size() - 1, false); // served status (excluding the depot)
+    vector<int> vehiclesUsed(fleet.types.size(), 0); // number of used vehicles of each type
+    // Each complete route is served by the smallest available vehicle that can carry its load
+    auto assignVehicle = [&](Route& route) {
+        int type = fleet.smallestAvailable(route.currentQuantity, vehiclesUsed);
+        vehiclesUsed[type]++;
+        route.vehicleCapacity = fleet.types[type].capacity;
+    };
     
     // Complexity - m (number of edges) and n (number of nodes)
     // m = 1/2 * n(n-1) ~= n^2
@@ -37,8 +46,10 @@ void savingsAlgorithm(const vector<Node>& nodes, const vector<Request>& requests
 
     // Step one:
     // Calculate the distance between every two customers and between each customer to the depot
-    // O(m)
-    vector<vector<double>> distanceMatrix = calculateDistanceMatrix(nodes);
+    // O(m) - done by the caller, the matrix is shared with the other algorithms (and cached by the server)
+
+    // The rest of the algorithm constructs the routes, there is no improvement phase
+    PhaseTimer constructTimer;
 
     // Step two:
     // Calculate all savings between every two customers. Rank the savings and omit those below zero.
@@ -59,7 +70,8 @@ void savingsAlgorithm(const vector<Node>& nodes, const vector<Request>& requests
     do {
         // Step three:
         // Choose two customers with maximum savings satisfied the truck load limit as the initial route.
-        Route route(vehicleCapacity);
+        // The route is built for the largest vehicle still available, a smaller one is assigned when it is complete.
+        Route route(fleet.types[fleet.largestAvailable(vehiclesUsed)].capacity, fleet.horizon);
         routesCnt++;
         // time - O(m)
         for (auto& candidateSavings: savings) {
@@ -107,9 +119,7 @@ void savingsAlgorithm(const vector<Node>& nodes, const vector<Request>& requests
                 Savings maxSavings = getMaxSavings(savings, candidateCustomerId, customersServed);
                 if (candidateNextSavings == maxSavings) {
                     // time - O(n)
-                    bool added = route.addCustomerIfCapacity(candidateCustomerId,
-                                                             requests[candidateCustomerId-2].quantity, start,
-                                                             distanceMatrix);
+                    bool added = route.addCustomerIfCapacity(candidateCustomerId, requests, start, distanceMatrix);
                     if (added) {
                         customersServed[candidateCustomerId-2] = true;
                     }
@@ -123,11 +133,16 @@ void savingsAlgorithm(const vector<Node>& nodes, const vector<Request>& requests
         // The algorithm was not specified well enough to decide what happens in this case therefore we
         // assume that customers are served one by one.
         if (route.getSize() == 0) {
-            createRouteForNotServedCustomers(customersServed, routes, vehicleCapacity,
+            size_t firstNew = routes.size();
+            createRouteForNotServedCustomers(customersServed, routes, fleet.maxCapacity(), fleet.horizon,
                                              requests, distanceMatrix);
+            for (size_t i = firstNew; i < routes.size(); i++) {
+                assignVehicle(routes[i]);
+            }
             break;
         }
         route.addDistancesToDepot(distanceMatrix);
+        assignVehicle(route);
         //O(n)
         routes.push_back(route);
 
@@ -139,43 +154,35 @@ void savingsAlgorithm(const vector<Node>& nodes, const vector<Request>& requests
     // TIMESTAMP: record the time after the algorithm ends and calculate its duration
     auto algorithmEnd = chrono::high_resolution_clock::now();
     auto algorithmDuration = chrono::duration_cast<chrono::microseconds>(algorithmEnd - algorithmStart);
+    auto constructTime = constructTimer.elapsed();
 
-    double totalDistance = 0;
-    int routeNum = 0;
-    int routesWithOneNode = 0;
-    int routesWithTwoNodes= 0;
-    double unusedCapacity = .0;
+    Solution solution;
+    solution.algorithm = "savings";
     for (auto& route : routes) {
-        routeNum++;
-        totalDistance += route.distance;
-        if (route.getSize() == 1) {
-            routesWithOneNode++;
-        } else if (route.getSize() == 2) {
-            routesWithTwoNodes++;
+        solution.distance += route.distance;
+        solution.routes.push_back(route.getCustomers());
+        if (!fleet.isUniform()) {
+            solution.capacities.push_back(route.vehicleCapacity);
         }
-        unusedCapacity = route.vehicleCapacity - route.currentQuantity;
-        cout << "#" << routeNum;
-        route.printOut();
     }
-    cout << "Overall distances " << totalDistance << endl;
-    cout << "Vehicles " << routeNum << endl;
-    cout << "Average number of customers " << nodes.size() / routeNum << endl;
-    cout << "Number of routes linking only one customer " << routesWithOneNode<< endl;
-    cout << "Number of routes linking only two customers " << routesWithTwoNodes << endl;
-    cout << "Unused capacity " << unusedCapacity << endl;
-    cout << "Time of the algorithm " << algorithmDuration.count() << " microseconds" << endl;
+    solution.algorithmTime = algorithmDuration.count();
+    solution.constructTime = constructTime;
+    solution.calculateStatistics(requests, fleet.maxCapacity());
+
+    return solution;
 }
 
 void createRouteForNotServedCustomers(const vector<bool>& isServed, vector<Route>& routes, double vehicleCapacity,
-                                      const vector<Request>& requests, const vector<vector<double>>& distanceMatrix) {
+                                      double horizon, const vector<Request>& requests, const DistanceMatrix& distanceMatrix) {
     vector<int> idsNotInRouteYet;
     for (int i = 0; i < (int)isServed.size(); i++) {
         if (!isServed[i]) idsNotInRouteYet.push_back(i+2);
     }
     // create routes for every customer that was not yet served
     for (auto& id : idsNotInRouteYet) {
-        Route newRoute(vehicleCapacity);
-        newRoute.addCustomerIfCapacity(id, requests[id-2].quantity, false, distanceMatrix);
+        Route newRoute(vehicleCapacity, horizon);
+        newRoute.addCustomerIfCapacity(id, requests, false, distanceMatrix);
+        newRoute.addDistancesToDepot(distanceMatrix);
         routes.push_back(newRoute);
     }
 }
@@ -193,7 +200,7 @@ Savings getMaxSavings(multiset<Savings, SavingsRanker>& savings, int customerId,
     return maxSavings;
 }
 
-Savings::Savings(int customerOneId, int customerTwoId, vector<vector<double>>& distanceMatrix) {
+Savings::Savings(int customerOneId, int customerTwoId, const DistanceMatrix& distanceMatrix) {
     this->customerOneId = customerOneId;
     this->customerTwoId = customerTwoId;
 
@@ -227,25 +234,49 @@ void Savings::printOut() const {
 }
 
 
-bool Route::addCustomerIfCapacity(int customerId, double requestedQuantity, bool start, const vector<vector<double>>& distanceMatrix) {
+bool Route::meetsTimeWindows(const TimeWindowSegment& customers, const DistanceMatrix& distanceMatrix) const {
+    auto depot = TimeWindowSegment::depot(horizon);
+    return depot.merge(customers, distanceMatrix).merge(depot, distanceMatrix).timeWarp <= 0;
+}
+
+bool Route::addCustomerIfCapacity(int customerId, const vector<Request>& requests, bool start, const DistanceMatrix& distanceMatrix) {
+    double requestedQuantity = requests[customerId-2].quantity;
     if (requestedQuantity + currentQuantity <= vehicleCapacity) {
-        currentQuantity += requestedQuantity;
-        if (start) {
-            distance += distanceMatrix[customerId-1][this->getStart()-1];
-            route.push_front(customerId);
+        auto customer = TimeWindowSegment::customer(customerId, requests);
+        if (route.empty()) {
+            segment = customer;
+            route.push_back(customerId); // no other customer to connect to, the depot is added by addDistancesToDepot
         } else {
-            distance += distanceMatrix[customerId-1][this->getEnd()-1];
-            route.push_back(customerId);
+            auto merged = start ? customer.merge(segment, distanceMatrix) : segment.merge(customer, distanceMatrix);
+            if (!meetsTimeWindows(merged, distanceMatrix)) {
+                return false;
+            }
+            segment = merged;
+            if (start) {
+                distance += distanceMatrix[customerId-1][this->getStart()-1];
+                route.push_front(customerId);
+            } else {
+                distance += distanceMatrix[customerId-1][this->getEnd()-1];
+                route.push_back(customerId);
+            }
         }
+        currentQuantity += requestedQuantity;
         return true;
     }
     return false;
 }
 
-bool Route::appendCustomersIfCapacity(int customerOneId, int customerTwoId, const vector<Request>& requests, const vector<vector<double>>& distanceMatrix) {
+bool Route::appendCustomersIfCapacity(int customerOneId, int customerTwoId, const vector<Request>& requests, const DistanceMatrix& distanceMatrix) {
     double requestedQuantity = requests[customerOneId-2].quantity + requests[customerTwoId-2].quantity;
 
     if (requestedQuantity + currentQuantity <= vehicleCapacity) {
+        auto pair = TimeWindowSegment::customer(customerOneId, requests)
+                        .merge(TimeWindowSegment::customer(customerTwoId, requests), distanceMatrix);
+        auto merged = route.empty() ? pair : segment.merge(pair, distanceMatrix);
+        if (!meetsTimeWindows(merged, distanceMatrix)) {
+            return false;
+        }
+        segment = merged;
         currentQuantity += requestedQuantity;
         route.push_back(customerOneId);
         route.push_back(customerTwoId);
@@ -256,8 +287,9 @@ bool Route::appendCustomersIfCapacity(int customerOneId, int customerTwoId, cons
 }
 
 
-Route::Route(double vehicleCapacity) {
+Route::Route(double vehicleCapacity, double horizon) {
     this->vehicleCapacity = vehicleCapacity;
+    this->horizon = horizon;
     this->currentQuantity = 0;
     this->distance = 0;
 }
@@ -277,10 +309,14 @@ void Route::printOut() const {
     cout << endl;
 }
 
+vector<int> Route::getCustomers() const {
+    return vector<int>(route.begin(), route.end());
+}
+
 int Route::getSize() const {
     return this->route.size();
 }
 
-void Route::addDistancesToDepot(const vector<vector<double>> &distanceMatrix) {
+void Route::addDistancesToDepot(const DistanceMatrix &distanceMatrix) {
     this->distance += distanceMatrix[0][this->getStart()-1] + distanceMatrix[0][this->getEnd()-1];
 }
@@ -2,6 +2,10 @@
 #define SAVINGS_HPP
 
 #include "../structures/DataReader.hpp"
+#include "../structures/Solution.hpp"
+#include "distancematrix.hpp"
+#include "fleet.hpp"
+#include "timewindows.hpp"
 #include <iostream>
 #include <set>
 #include <list>
@@ -9,7 +13,8 @@
 
 using namespace std;
 
-void savingsAlgorithm(const vector<Node>& nodes, const vector<Request>& requests, double vehicleCapacity);
+Solution savingsAlgorithm(const vector<Node>& nodes, const vector<Request>& requests, const Fleet& fleet,
+                          const DistanceMatrix& distanceMatrix);
 
 class Savings {
 public:
@@ -28,7 +33,7 @@ public:
      * @param distanceMatrix the precalculated matrix of distances between customers,
      *                       as well as their distance from the depot
      */
-    Savings(int customerOneId, int customerTwoId, vector<vector<double>>& distanceMatrix);
+    Savings(int customerOneId, int customerTwoId, const DistanceMatrix& distanceMatrix);
 
 
     /**
@@ -56,29 +61,43 @@ public:
     double vehicleCapacity;     // vehicle that will be covering the route
     double currentQuantity;     // quantity required by the customers on the route
     double distance;            // distance covered by the route
+    double horizon;             // the latest return to the depot
+    TimeWindowSegment segment;  // timing of the customers on the route, see timewindows.hpp
 
     /**
      * Constructs empty route with allocated capacity of the vehicle that will be covering the route.
      * @param vehicleCapacity capacity of the vehicle that will be covering the route
+     * @param horizon the latest return of the vehicle to the depot
      */
-    explicit Route(double vehicleCapacity);
+    explicit Route(double vehicleCapacity, double horizon = numeric_limits<double>::infinity());
+
+    /**
+     * Checks whether the customers of the segment can be served on time when the vehicle starts from the depot
+     * and returns there. Thanks to the segments it takes O(1), the route is not simulated again.
+     * @param customers segment of the customers of the route (after a merge)
+     * @param distanceMatrix matrix that contains distances (travel times) between all nodes in the graph
+     * @return true if no time window is violated
+     */
+    bool meetsTimeWindows(const TimeWindowSegment& customers, const DistanceMatrix& distanceMatrix) const;
 
     /**
      * Adds the given customer ID to the route. It allows to specify if the customer should be added at the beginning or
      * the end of the route. The currentQuantity and distance is updated accordingly to given parameters.
+     * The customer is not added if the route would violate a time window (unless it is the only customer).
      * @param customerId  ID of the customer that will be added to the route
-     * @param requestedQuantity  quantity of goods requested by the customer
+     * @param requests requests containing the quantity of goods and the time window of the customer
      * @param start if true, the customer should be added at the start of the route. If false, the customer
      *              will be added at the end of the route
      * @param distanceMatrix matrix that contains distances between all nodes in the graph (customers as well as the depot)
      * @return
      */
-    bool addCustomerIfCapacity(int customerId, double requestedQuantity, bool start, const vector<vector<double>>& distanceMatrix);
+    bool addCustomerIfCapacity(int customerId, const vector<Request>& requests, bool start, const DistanceMatrix& distanceMatrix);
 
     /**
      * Appends given customer IDs to the end of the route. It also updates the currentQuantity required on the route as
      * well as the distance covered by the route. It is intended to initialize the route with pair of nodes that
-     * have largest savings (as part of the Savings algorithm).
+     * have largest savings (as part of the Savings algorithm). The customers are not added if the route would violate
+     * a time window.
      * @param customerOneId ID of the first customer that will be added to the route
      * @param customerTwoId ID of the second customer that will be added to the route
      * @param requests requests containing the information about requested quantity of goods by a customer used to
@@ -86,14 +105,14 @@ public:
      * @param distanceMatrix matrix that contains distances between all nodes in the graph (customers as well as the depot)
      * @return
      */
-    bool appendCustomersIfCapacity(int customerOneId, int customerTwoId, const vector<Request>& requests, const vector<vector<double>>& distanceMatrix);
+    bool appendCustomersIfCapacity(int customerOneId, int customerTwoId, const vector<Request>& requests, const DistanceMatrix& distanceMatrix);
 
     /**
      * Adds the distance from depot to the beginning of route as well as the distance from the end of route to the depot.
      * Should be added when the route is complete (no additional customers will be added).
      * @param distanceMatrix matrix that contains distances between all nodes in the graph (customers as well as the depot)
      */
-    void addDistancesToDepot(const vector<vector<double>>& distanceMatrix);
+    void addDistancesToDepot(const DistanceMatrix& distanceMatrix);
 
     /**
      * Retrieves the first customer id in the route.
@@ -107,6 +126,12 @@ public:
      */
     int getEnd() const;
 
+    /**
+     * Retrieves the customer IDs on the route in the order they are visited.
+     * @return IDs of the customers on the route (without the depot)
+     */
+    vector<int> getCustomers() const;
+
     /**
      * Retrieves the size of route.
      * @return
@@ -121,6 +146,6 @@ public:
 };
 
 void createRouteForNotServedCustomers(const vector<bool>& isServed, vector<Route>& routes, double vehicleCapacity,
-                                      const vector<Request>& requests, const vector<vector<double>>& distanceMatrix);
+                                      double horizon, const vector<Request>& requests, const DistanceMatrix& distanceMatrix);
 
 #endif //SAVINGS_HPP
\ No newline at end of file
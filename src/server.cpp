@@ -0,0 +1,338 @@
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server.hpp"
+#include "solver.hpp"
+#include "threadpool.hpp"
+#include "timing.hpp"
+#include "util.hpp"
+
+static const size_t MAX_MESSAGE_SIZE = 256 * 1024 * 1024;
+static const size_t PROBLEM_CACHE_SIZE = 256;
+static const size_t MATRIX_CACHE_SIZE = 32; // matrices are O(n^2), keep fewer of them
+
+static atomic<bool> stopRequested(false);
+
+static void requestStop(int) {
+    stopRequested = true;
+}
+
+/**
+ * Thread-safe cache keeping the least recently used entries up to the given count
+ */
+template <typename Value>
+class LruCache {
+private:
+    size_t capacity;
+    mutex lock;
+    list<pair<uint64_t, shared_ptr<const Value>>> entries; // the most recently used first
+    unordered_map<uint64_t, typename list<pair<uint64_t, shared_ptr<const Value>>>::iterator> index;
+
+public:
+    explicit LruCache(size_t capacity) : capacity(capacity) {}
+
+    shared_ptr<const Value> get(uint64_t key) {
+        lock_guard<mutex> guard(lock);
+        auto found = index.find(key);
+        if (found == index.end()) {
+            return nullptr;
+        }
+        entries.splice(entries.begin(), entries, found->second);
+        return found->second->second;
+    }
+
+    void put(uint64_t key, shared_ptr<const Value> value) {
+        lock_guard<mutex> guard(lock);
+        auto found = index.find(key);
+        if (found != index.end()) {
+            entries.erase(found->second);
+        }
+        entries.emplace_front(key, value);
+        index[key] = entries.begin();
+        if (entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+};
+
+struct ServerState {
+    LruCache<Problem> problems{PROBLEM_CACHE_SIZE};                 // keyed by the hash of the instance XML
+    LruCache<DistanceMatrix> matrices{MATRIX_CACHE_SIZE};   // keyed by the hash of the coordinates and matrix options
+    SolverOptions defaults;
+    mutex clientsLock;
+    condition_variable clientsClosed; // notified when the last connection is closed
+    set<int> clients;
+};
+
+static bool readAll(int fd, char* buffer, size_t size) {
+    while (size > 0) {
+        ssize_t received = read(fd, buffer, size);
+        if (received <= 0) {
+            if (received < 0 and errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        buffer += received;
+        size -= received;
+    }
+    return true;
+}
+
+static bool writeAll(int fd, const char* buffer, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, buffer, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        buffer += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+static bool readMessage(int fd, string& message) {
+    uint32_t length;
+    if (!readAll(fd, reinterpret_cast<char*>(&length), sizeof(length))) {
+        return false;
+    }
+    length = ntohl(length);
+    if (length > MAX_MESSAGE_SIZE) {
+        return false;
+    }
+    message.resize(length);
+    return readAll(fd, message.data(), length);
+}
+
+static bool writeMessage(int fd, const string& message) {
+    uint32_t length = htonl(message.size());
+    return writeAll(fd, reinterpret_cast<const char*>(&length), sizeof(length))
+           and writeAll(fd, message.data(), message.size());
+}
+
+static string handleRequest(ServerState& state, const string& request) {
+    // Split the headers from the instance
+    SolverOptions options = state.defaults;
+    string format = "json";
+    size_t position = 0;
+    while (position < request.size()) {
+        size_t end = request.find('\n', position);
+        if (end == string::npos) {
+            throw invalid_argument("The request has to contain an empty line between the headers and the instance");
+        }
+        string line = request.substr(position, end - position);
+        position = end + 1;
+        if (line.empty() or line == "\r") {
+            break;
+        }
+        istringstream header(line);
+        string key, value;
+        header >> key >> value;
+        if (key == "algorithm") {
+            if (!Solver::isAlgorithm(value)) {
+                throw invalid_argument("Unknown algorithm " + value);
+            }
+            options.algorithm = value;
+        } else if (key == "output") {
+            if (value != "json" and value != "csv" and value != "text") {
+                throw invalid_argument("Unknown output format " + value);
+            }
+            format = value;
+        } else if (key == "seed") {
+            if (value.empty() or value.find_first_not_of("0123456789") != string::npos) {
+                throw invalid_argument("The seed has to be a non-negative integer");
+            }
+            options.seed = stoull(value);
+        } else {
+            throw invalid_argument("Unknown header " + key);
+        }
+    }
+    string xml = request.substr(position);
+
+    PhaseTimer parseTimer;
+    uint64_t problemKey = hashBytes(xml.data(), xml.size());
+    auto problem = state.problems.get(problemKey);
+    if (!problem) {
+        auto parsed = make_shared<Problem>(Problem::parse(xml));
+        parsed->validate();
+        problem = parsed;
+        state.problems.put(problemKey, problem);
+    }
+    auto parseTime = parseTimer.elapsed();
+
+    PhaseTimer matrixTimer;
+    uint64_t matrixKey = hashCoordinates(problem->nodes);
+    matrixKey = hashBytes(&options.matrixPrecision, sizeof(options.matrixPrecision), matrixKey);
+    matrixKey = hashBytes(options.distanceMatrix.data(), options.distanceMatrix.size(), matrixKey);
+    matrixKey = hashBytes(&options.rounding, sizeof(options.rounding), matrixKey);
+    auto distanceMatrix = state.matrices.get(matrixKey);
+    if (!distanceMatrix) {
+        distanceMatrix = make_shared<DistanceMatrix>(Solver::distanceMatrix(*problem, options));
+        state.matrices.put(matrixKey, distanceMatrix);
+    }
+    auto matrixTime = matrixTimer.elapsed();
+
+    Solution solution = Solver::solve(*problem, options, *distanceMatrix);
+    solution.parseTime = parseTime;
+    solution.matrixTime = matrixTime;
+
+    ostringstream response;
+    response << "ok\n";
+    if (format == "json") {
+        solution.printJson(response);
+    } else if (format == "csv") {
+        response << Solution::csvHeader() << "\n";
+        solution.printCsv(response);
+    } else {
+        solution.printOut(response);
+    }
+    return response.str();
+}
+
+/**
+ * Serves the requests of one connection on its own thread, only the solves are run by the workers of the pool,
+ * so an idle connection waiting for its next request does not keep a worker from the other clients.
+ */
+static void serveClient(ServerState& state, ThreadPool& pool, int client) {
+    string request;
+    while (!stopRequested and readMessage(client, request)) {
+        auto solved = make_shared<promise<string>>();
+        double weight = request.size();
+        pool.submit([&state, request = move(request), solved] {
+            try {
+                solved->set_value(handleRequest(state, request));
+            } catch (...) {
+                solved->set_exception(current_exception());
+            }
+        }, weight);
+        string response;
+        try {
+            response = solved->get_future().get();
+        } catch (const exception& e) {
+            response = string("error\n") + e.what() + "\n";
+        }
+        if (!writeMessage(client, response)) {
+            break;
+        }
+    }
+    close(client);
+    lock_guard<mutex> guard(state.clientsLock);
+    state.clients.erase(client);
+    if (state.clients.empty()) {
+        state.clientsClosed.notify_all();
+    }
+}
+
+/**
+ * Removes the socket file left behind by a server that is no longer running, any other file is kept.
+ * @return false if the path is taken by another file or by a running server
+ */
+static bool removeStaleSocket(const string& socketPath, const sockaddr_un& address) {
+    struct stat status;
+    if (lstat(socketPath.c_str(), &status) < 0) {
+        return errno == ENOENT;
+    }
+    if (!S_ISSOCK(status.st_mode)) {
+        cerr << socketPath << " exists and it is not a socket" << endl;
+        return false;
+    }
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    bool running = probe >= 0 and connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    if (probe >= 0) {
+        close(probe);
+    }
+    if (running) {
+        cerr << "Another server is listening on " << socketPath << endl;
+        return false;
+    }
+    return unlink(socketPath.c_str()) == 0 or errno == ENOENT;
+}
+
+int serve(const string& socketPath, size_t jobs, const SolverOptions& defaults) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "The socket path is too long: " << socketPath << endl;
+        return EXIT_FAILURE;
+    }
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        cerr << "Cannot create the socket: " << strerror(errno) << endl;
+        return EXIT_FAILURE;
+    }
+    if (!removeStaleSocket(socketPath, address)) {
+        close(listener);
+        return EXIT_FAILURE;
+    }
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 or listen(listener, 64) < 0) {
+        cerr << "Cannot listen on " << socketPath << ": " << strerror(errno) << endl;
+        close(listener);
+        return EXIT_FAILURE;
+    }
+
+    // Interrupt accept() on SIGINT/SIGTERM (no SA_RESTART) so that the socket file can be removed
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    ServerState state;
+    state.defaults = defaults;
+    {
+        ThreadPool pool(jobs);
+        cerr << "Listening on " << socketPath << " with " << pool.size() << " workers" << endl;
+        while (!stopRequested) {
+            int client = accept(listener, nullptr, nullptr);
+            if (client < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                cerr << "Cannot accept the connection: " << strerror(errno) << endl;
+                break;
+            }
+            lock_guard<mutex> guard(state.clientsLock);
+            try {
+                thread(serveClient, ref(state), ref(pool), client).detach();
+                state.clients.insert(client);
+            } catch (const system_error& e) {
+                cerr << "Cannot serve the connection: " << e.what() << endl;
+                close(client);
+            }
+        }
+
+        // Wake up the clients waiting for their next request, the running solves are finished first
+        unique_lock<mutex> guard(state.clientsLock);
+        for (auto client : state.clients) {
+            shutdown(client, SHUT_RD);
+        }
+        state.clientsClosed.wait(guard, [&state] { return state.clients.empty(); });
+    }
+
+    close(listener);
+    unlink(socketPath.c_str());
+    return EXIT_SUCCESS;
+}
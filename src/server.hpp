@@ -0,0 +1,31 @@
+/**
+ * Solver daemon - serves solve requests over a Unix domain socket
+ * The parsed problems and the distance matrices of recently seen instances are kept in memory, so re-solving
+ * the same network (even with different requests) skips the parsing and the calculation of the matrix.
+ *
+ * Protocol: every message (request and response) is a 4-byte big-endian length followed by the payload.
+ *   request payload:  header lines "<key> <value>" ('algorithm', 'output', 'seed'), an empty line and the instance XML
+ *   response payload: "ok\n" followed by the solution in the requested format or "error\n" followed by the message
+ * A client may send any number of requests over one connection, they are answered in order. Every connection is
+ * read on its own thread and only its solves wait for the workers, so idle connections do not block the others.
+**/
+
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <string>
+#include "solver.hpp"
+
+using namespace std;
+
+/**
+ * Listens on the socket and solves the requests until SIGINT or SIGTERM is received.
+ * @param socketPath path of the Unix domain socket, a socket file left behind by a server that is no longer running
+ *                   is replaced, any other existing file is kept and the server fails
+ * @param jobs number of requests solved concurrently, 0 means one per hardware thread
+ * @param defaults options used for every request unless the request overrides them (e.g. the matrix cache)
+ * @return EXIT_SUCCESS after a clean shutdown, EXIT_FAILURE if the socket cannot be created
+ */
+int serve(const string& socketPath, size_t jobs, const SolverOptions& defaults);
+
+#endif //SERVER_HPP
@@ -0,0 +1,477 @@
+#include <algorithm>
+#include <stdexcept>
+#include "session.hpp"
+#include "routeopt.hpp"
+#include "util.hpp"
+
+static const size_t SESSION_NEIGHBOURS = 20;    // the nearest customers of every customer tried by the repair
+static const size_t SESSION_REPAIR_MOVES = 50;  // the most moves of the repair after one event
+
+Session::Session(const Problem& problem, const SolverOptions& options) : current(problem), options(options) {
+    if (problem.depotCount() > 1) {
+        throw invalid_argument("The session supports a single depot only");
+    }
+    matrix = Solver::distanceMatrix(current, options);
+    fleet = Solver::fleet(current, options);
+    Solution initial = Solver::solve(current, options, matrix);
+
+    vehiclesUsed.assign(fleet.types.size(), 0);
+    routeOf.assign(current.nodes.size() + 1, -1);
+    for (size_t r = 0; r < initial.routes.size(); r++) {
+        double capacity = r < initial.capacities.size() ? initial.capacities[r] : fleet.maxCapacity();
+        SessionRoute route;
+        route.customers = initial.routes[r];
+        while (route.type + 1 < (int)fleet.types.size() and fleet.types[route.type].capacity < capacity) {
+            route.type++; // the types are sorted by the capacity
+        }
+        vehiclesUsed[route.type]++;
+        routes.push_back(route);
+        refresh(routes.size() - 1);
+    }
+    neighbours.assign(current.nodes.size() + 1, vector<int>());
+    for (size_t customer = 2; customer <= current.nodes.size(); customer++) {
+        neighbours[customer] = nearestCustomers(customer);
+    }
+}
+
+// Recalculates the cached values of the route after it was modified
+void Session::refresh(size_t r) {
+    auto& route = routes[r];
+    route.load = 0;
+    route.distance = 0;
+    int previous = 0;
+    for (auto& customer : route.customers) {
+        route.load += current.requests[customer-2].quantity;
+        route.distance += matrix[previous][customer-1];
+        previous = customer - 1;
+        routeOf[customer] = r;
+    }
+    route.distance += matrix[previous][0];
+    route.timeWarp = 0;
+    route.timing.reset();
+    if (fleet.timeWindows) {
+        route.timing.emplace(route.customers, current.requests, fleet.horizon, matrix);
+        route.timeWarp = route.timing->timeWarp();
+    }
+}
+
+// Distance of the route with the penalized time warp
+double Session::routeCost(const SessionRoute& route) const {
+    return route.distance + route.timeWarp * TIME_WARP_PENALTY;
+}
+
+void Session::checkCustomer(int id) const {
+    if (id < 2 or id > (int)current.nodes.size() or routeOf[id] < 0) {
+        throw invalid_argument("There is no customer " + to_string(id));
+    }
+}
+
+/**
+ * Fills in the distances of the last node, the matrix is copied into a twice as large one when it is full
+ * (or when it is mapped from a file and cannot be modified)
+ * Time complexity: O(n), amortized with the copies
+*/
+void Session::growMatrix() {
+    size_t size = current.nodes.size();
+    if (matrix.size() < size or matrix.isMapped()) {
+        DistanceMatrix grown(max(size, 2 * matrix.size()), matrix.precision());
+        for (size_t i = 0; i + 1 < size; i++) {
+            for (size_t j = 0; j + 1 < size; j++) {
+                grown.set(i, j, matrix[i][j]);
+            }
+        }
+        matrix = move(grown);
+    }
+    DistanceRounding rounding = options.rounding;
+    if (matrix.precision() == MatrixPrecision::Int32 and rounding == DistanceRounding::None) {
+        rounding = DistanceRounding::Nearest;
+    }
+    const Node& node = current.nodes.back();
+    for (size_t j = 0; j < size; j++) {
+        double dist = roundDistance(distance(node, current.nodes[j]), rounding);
+        matrix.set(size - 1, j, dist);
+        matrix.set(j, size - 1, dist);
+    }
+}
+
+// The nearest active customers of the customer
+vector<int> Session::nearestCustomers(int customer) const {
+    vector<int> nearest;
+    for (size_t other = 2; other <= current.nodes.size(); other++) {
+        if ((int)other != customer and routeOf[other] >= 0) {
+            nearest.push_back(other);
+        }
+    }
+    size_t count = min(SESSION_NEIGHBOURS, nearest.size());
+    partial_sort(nearest.begin(), nearest.begin() + count, nearest.end(), [&](int a, int b) {
+        return matrix[customer-1][a-1] < matrix[customer-1][b-1];
+    });
+    nearest.resize(count);
+    return nearest;
+}
+
+// Adds the new customer to the neighbour lists of the customers it is closer to than their farthest neighbour
+void Session::addNeighbour(int customer) {
+    neighbours.resize(current.nodes.size() + 1);
+    neighbours[customer] = nearestCustomers(customer);
+    for (size_t other = 2; other < current.nodes.size() + 1; other++) {
+        auto& list = neighbours[other];
+        if ((int)other == customer or routeOf[other] < 0) {
+            continue;
+        }
+        auto row = matrix[other-1];
+        if (list.size() < SESSION_NEIGHBOURS or row[customer-1] < row[list.back()-1]) {
+            auto position = lower_bound(list.begin(), list.end(), customer, [&](int a, int b) {
+                return row[a-1] < row[b-1];
+            });
+            list.insert(position, customer);
+            if (list.size() > SESSION_NEIGHBOURS) {
+                list.pop_back();
+            }
+        }
+    }
+}
+
+// Replaces the cancelled customer in the neighbour lists by the next nearest customers
+void Session::removeNeighbour(int customer) {
+    for (size_t other = 2; other < current.nodes.size() + 1; other++) {
+        auto& list = neighbours[other];
+        if (routeOf[other] >= 0 and find(list.begin(), list.end(), customer) != list.end()) {
+            list = nearestCustomers(other);
+        }
+    }
+    neighbours[customer].clear();
+}
+
+/**
+ * Inserts the customer at the cheapest position of a route with enough capacity, or into a new route if it is
+ * cheaper and a vehicle is left (a new route is opened also if the customer fits nowhere)
+ * Time complexity: O(n)
+*/
+size_t Session::insertCustomer(int customer) {
+    double quantity = current.requests[customer-2].quantity;
+    double bestCost = numeric_limits<double>::infinity();
+    size_t bestRoute = routes.size();
+    size_t bestPosition = 0;
+    for (size_t r = 0; r < routes.size(); r++) {
+        auto& route = routes[r];
+        if (route.load + quantity > fleet.types[route.type].capacity) {
+            continue;
+        }
+        for (size_t position = 0; position <= route.customers.size(); position++) {
+            int previous = position == 0 ? 0 : route.customers[position-1] - 1;
+            int next = position == route.customers.size() ? 0 : route.customers[position] - 1;
+            double cost = matrix[previous][customer-1] + matrix[customer-1][next] - matrix[previous][next];
+            if (route.timing) {
+                cost += (route.timing->insertionTimeWarp(position, customer) - route.timeWarp) * TIME_WARP_PENALTY;
+            }
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestRoute = r;
+                bestPosition = position;
+            }
+        }
+    }
+
+    int type = fleet.smallestAvailable(quantity, vehiclesUsed);
+    bool vehicleLeft = (fleet.maxVehicles < 0 or (int)routes.size() < fleet.maxVehicles)
+                       and (fleet.types[type].count < 0 or vehiclesUsed[type] < fleet.types[type].count);
+    double alone = matrix[0][customer-1] + matrix[customer-1][0];
+    if (fleet.timeWindows) {
+        alone += routeTimeWarp({customer}, current.requests, fleet.horizon, matrix) * TIME_WARP_PENALTY;
+    }
+    if (bestRoute == routes.size() or (vehicleLeft and alone < bestCost)) {
+        SessionRoute route;
+        route.type = type;
+        vehiclesUsed[type]++;
+        routes.push_back(route);
+        bestRoute = routes.size() - 1;
+        bestPosition = 0;
+    }
+    auto& customers = routes[bestRoute].customers;
+    customers.insert(customers.begin() + bestPosition, customer);
+    refresh(bestRoute);
+    return bestRoute;
+}
+
+// Takes the customer out of its route, the route is kept even if it is empty
+size_t Session::detachCustomer(int customer) {
+    size_t r = routeOf[customer];
+    auto& customers = routes[r].customers;
+    customers.erase(find(customers.begin(), customers.end(), customer));
+    routeOf[customer] = -1;
+    refresh(r);
+    return r;
+}
+
+// Removes the route, the last route takes its place
+void Session::dropRoute(size_t r) {
+    vehiclesUsed[routes[r].type]--;
+    if (r + 1 < routes.size()) {
+        routes[r] = move(routes.back());
+        routes.pop_back();
+        refresh(r);
+    } else {
+        routes.pop_back();
+    }
+}
+
+/**
+ * Change of the cost of the route if the customer at the position is replaced by another one
+ * Time complexity: O(1), O(R) with time windows
+*/
+double Session::replacementCost(const SessionRoute& route, size_t position, int customer) const {
+    int previous = position == 0 ? 0 : route.customers[position-1] - 1;
+    int next = position + 1 == route.customers.size() ? 0 : route.customers[position+1] - 1;
+    int replaced = route.customers[position] - 1;
+    double cost = matrix[previous][customer-1] + matrix[customer-1][next]
+                  - matrix[previous][replaced] - matrix[replaced][next];
+    if (route.timing) {
+        vector<int> replacedRoute = route.customers;
+        replacedRoute[position] = customer;
+        double timeWarp = routeTimeWarp(replacedRoute, current.requests, fleet.horizon, matrix);
+        cost += (timeWarp - route.timeWarp) * TIME_WARP_PENALTY;
+    }
+    return cost;
+}
+
+/**
+ * Repairs the solution around the event: the customers close to it are relocated next to their nearest neighbours
+ * in other routes, swapped with them or the tails of the two routes are exchanged (a swap or an exchange of the
+ * tails moves the load between the routes, so it helps when the vehicles are full) while it helps (at most
+ * SESSION_REPAIR_MOVES times), then the touched routes are reordered
+ * Time complexity: O(M * K * R) for M moves, K neighbours and routes of length R, plus the reordering
+*/
+void Session::repair(vector<int> around, vector<size_t> touched) {
+    for (size_t r : touched) {
+        for (int customer : routes[r].customers) {
+            around.push_back(customer);
+        }
+    }
+    size_t moves = 0;
+    for (size_t i = 0; i < around.size() and moves < SESSION_REPAIR_MOVES; i++) {
+        int u = around[i];
+        if (routeOf[u] < 0) {
+            continue;
+        }
+        size_t a = routeOf[u];
+        auto& from = routes[a];
+        size_t position = find(from.customers.begin(), from.customers.end(), u) - from.customers.begin();
+        int previous = position == 0 ? 0 : from.customers[position-1] - 1;
+        int next = position + 1 == from.customers.size() ? 0 : from.customers[position+1] - 1;
+        double removal = matrix[previous][next] - matrix[previous][u-1] - matrix[u-1][next];
+        if (from.timing) {
+            removal += (from.timing->removalTimeWarp(position) - from.timeWarp) * TIME_WARP_PENALTY;
+        }
+        double quantity = current.requests[u-2].quantity;
+
+        double bestDelta = -1e-9;
+        size_t bestRoute = 0, bestPosition = 0;
+        for (int v : neighbours[u]) {
+            size_t b = routeOf[v];
+            auto& to = routes[b];
+            if (b == a or to.load + quantity > fleet.types[to.type].capacity) {
+                continue;
+            }
+            size_t at = find(to.customers.begin(), to.customers.end(), v) - to.customers.begin();
+            for (size_t p = at; p <= at + 1; p++) {
+                int before = p == 0 ? 0 : to.customers[p-1] - 1;
+                int after = p == to.customers.size() ? 0 : to.customers[p] - 1;
+                double delta = removal + matrix[before][u-1] + matrix[u-1][after] - matrix[before][after];
+                if (to.timing) {
+                    delta += (to.timing->insertionTimeWarp(p, u) - to.timeWarp) * TIME_WARP_PENALTY;
+                }
+                if (delta < bestDelta) {
+                    bestDelta = delta;
+                    bestRoute = b;
+                    bestPosition = p;
+                }
+            }
+        }
+        int swapped = 0;
+        for (int v : neighbours[u]) {
+            size_t b = routeOf[v];
+            auto& to = routes[b];
+            double other = current.requests[v-2].quantity;
+            if (b == a or from.load - quantity + other > fleet.types[from.type].capacity
+                or to.load - other + quantity > fleet.types[to.type].capacity) {
+                continue;
+            }
+            size_t at = find(to.customers.begin(), to.customers.end(), v) - to.customers.begin();
+            double delta = replacementCost(from, position, v) + replacementCost(to, at, u);
+            if (delta < bestDelta) {
+                bestDelta = delta;
+                bestRoute = b;
+                bestPosition = at;
+                swapped = v;
+            }
+        }
+        // the tails of the routes are exchanged so that v follows u (2-opt*), that moves load between full routes
+        size_t crossed = routes.size();
+        vector<int> crossedFrom, crossedTo;
+        double prefixLoad = 0;
+        for (size_t k = 0; k <= position; k++) {
+            prefixLoad += current.requests[from.customers[k]-2].quantity;
+        }
+        for (int v : neighbours[u]) {
+            size_t b = routeOf[v];
+            auto& to = routes[b];
+            if (b == a) {
+                continue;
+            }
+            size_t at = find(to.customers.begin(), to.customers.end(), v) - to.customers.begin();
+            double headLoad = 0;
+            for (size_t k = 0; k < at; k++) {
+                headLoad += current.requests[to.customers[k]-2].quantity;
+            }
+            if (prefixLoad + to.load - headLoad > fleet.types[from.type].capacity
+                or headLoad + from.load - prefixLoad > fleet.types[to.type].capacity) {
+                continue;
+            }
+            int before = at == 0 ? 0 : to.customers[at-1] - 1;
+            double delta = matrix[u-1][v-1] + matrix[before][next] - matrix[u-1][next] - matrix[before][v-1];
+            vector<int> first(from.customers.begin(), from.customers.begin() + position + 1);
+            first.insert(first.end(), to.customers.begin() + at, to.customers.end());
+            vector<int> second(to.customers.begin(), to.customers.begin() + at);
+            second.insert(second.end(), from.customers.begin() + position + 1, from.customers.end());
+            if (fleet.timeWindows) {
+                double timeWarp = routeTimeWarp(first, current.requests, fleet.horizon, matrix)
+                                  + routeTimeWarp(second, current.requests, fleet.horizon, matrix);
+                delta += (timeWarp - from.timeWarp - to.timeWarp) * TIME_WARP_PENALTY;
+            }
+            if (delta < bestDelta) {
+                bestDelta = delta;
+                crossed = b;
+                crossedFrom = move(first);
+                crossedTo = move(second);
+                swapped = 0;
+            }
+        }
+        if (crossed < routes.size()) {
+            from.customers = move(crossedFrom);
+            routes[crossed].customers = move(crossedTo);
+            refresh(a);
+            refresh(crossed);
+            touched.push_back(a);
+            touched.push_back(crossed);
+            if (next != 0) {
+                around.push_back(next + 1); // the former successor of u
+            }
+            moves++;
+        } else if (swapped != 0) {
+            from.customers[position] = swapped;
+            routes[bestRoute].customers[bestPosition] = u;
+            refresh(a);
+            refresh(bestRoute);
+            touched.push_back(a);
+            touched.push_back(bestRoute);
+            around.push_back(swapped);
+            moves++;
+        } else if (bestDelta < -1e-9) {
+            from.customers.erase(from.customers.begin() + position);
+            refresh(a);
+            routes[bestRoute].customers.insert(routes[bestRoute].customers.begin() + bestPosition, u);
+            refresh(bestRoute);
+            touched.push_back(a);
+            touched.push_back(bestRoute);
+            moves++;
+        }
+    }
+
+    sort(touched.begin(), touched.end());
+    touched.erase(unique(touched.begin(), touched.end()), touched.end());
+    for (size_t r : touched) {
+        if (routes[r].customers.empty()) {
+            continue;
+        }
+        vector<int> order = routes[r].customers;
+        double distance = optimizeRoute(order, matrix);
+        double timeWarp = fleet.timeWindows ? routeTimeWarp(order, current.requests, fleet.horizon, matrix) : 0;
+        if (distance + timeWarp * TIME_WARP_PENALTY < routeCost(routes[r]) - 1e-9) {
+            routes[r].customers = order;
+            refresh(r);
+        }
+    }
+    // the routes emptied by the event are dropped from the last one, so the indices of the others stay valid
+    for (size_t r = routes.size(); r-- > 0;) {
+        if (routes[r].customers.empty()) {
+            dropRoute(r);
+        }
+    }
+}
+
+int Session::addCustomer(double x, double y, double quantity, double ready, double due, double service) {
+    if (!options.distanceMatrix.empty()) {
+        throw logic_error("Customers cannot be added to a problem with an explicit distance matrix");
+    }
+    if (quantity > fleet.maxCapacity()) {
+        throw invalid_argument("The demand " + to_string(quantity) + " exceeds the vehicle capacity");
+    }
+    int id = current.addCustomer(x, y, quantity, ready, due, service);
+    growMatrix();
+    routeOf.push_back(-1);
+    if (!fleet.timeWindows and hasTimeWindows({current.requests.back()})) {
+        // the first customer with a time window, the routes need their timing from now on
+        fleet.timeWindows = true;
+        for (size_t r = 0; r < routes.size(); r++) {
+            refresh(r);
+        }
+    }
+    size_t r = insertCustomer(id);
+    addNeighbour(id);
+    repair(vector<int>(1, id), vector<size_t>(1, r));
+    return id;
+}
+
+void Session::removeCustomer(int id) {
+    checkCustomer(id);
+    size_t r = detachCustomer(id);
+    vector<int> around = neighbours[id];
+    removeNeighbour(id);
+    repair(around, vector<size_t>(1, r));
+}
+
+void Session::changeDemand(int id, double quantity) {
+    checkCustomer(id);
+    if (quantity > fleet.maxCapacity()) {
+        throw invalid_argument("The demand " + to_string(quantity) + " exceeds the vehicle capacity");
+    }
+    current.requests[id-2].quantity = quantity;
+    size_t r = routeOf[id];
+    refresh(r);
+    vector<size_t> touched(1, r);
+    if (routes[r].load > fleet.types[routes[r].type].capacity) {
+        // the route is overloaded, the customer moves to a route with enough capacity
+        detachCustomer(id);
+        touched.push_back(insertCustomer(id));
+    }
+    vector<int> around = neighbours[id];
+    around.push_back(id);
+    repair(around, touched);
+}
+
+Solution Session::solution() const {
+    Solution solution;
+    solution.algorithm = options.algorithm;
+    solution.instance = current.name;
+    for (auto& route : routes) {
+        solution.routes.push_back(route.customers);
+        solution.distance += route.distance;
+        if (!fleet.isUniform()) {
+            solution.capacities.push_back(fleet.types[route.type].capacity);
+        }
+    }
+    if (fleet.timeWindows) {
+        solution.timeWindows = true;
+        solution.timeWarp = 0;
+        for (auto& route : routes) {
+            solution.timeWarp += route.timeWarp;
+        }
+    }
+    solution.calculateStatistics(current.requests, fleet.maxCapacity());
+    return solution;
+}
+
+const Problem& Session::problem() const {
+    return current;
+}
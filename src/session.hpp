@@ -0,0 +1,122 @@
+/**
+ * Incremental re-optimization of a solution during the day
+ * The session solves the problem once and then keeps the solution up to date as the customers are added, cancelled
+ * or change their demands. Every event is applied by the cheapest feasible insertion or the removal of the customer,
+ * followed by a bounded local repair: the routes touched by the event are reordered (see routeopt.hpp) and a few
+ * relocations, swaps and exchanges of route tails (2-opt*) of their customers with their nearest neighbours are
+ * tried. The repair never dissolves a route, so a customer that fits into no route keeps the route opened for it.
+ * The loads, distances and time-window segments of the routes and the nearest neighbours of the customers are
+ * cached, an added customer only fills in its row and column of the distance matrix (the matrix is allocated with
+ * room to grow).
+ * The IDs of the customers never change, a cancelled customer keeps its ID and is left out of the routes.
+**/
+
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include <limits>
+#include <optional>
+#include <vector>
+#include "../structures/Problem.hpp"
+#include "../structures/Solution.hpp"
+#include "distancematrix.hpp"
+#include "fleet.hpp"
+#include "solver.hpp"
+#include "timewindows.hpp"
+
+using namespace std;
+
+class Session {
+private:
+    // Route of the session with its cached values
+    struct SessionRoute {
+        vector<int> customers;
+        double load = 0;
+        double distance = 0;
+        double timeWarp = 0;
+        int type = 0; // index of the vehicle type of the fleet serving the route
+        optional<RouteTimeWindows> timing; // only with time windows
+    };
+
+    Problem current;
+    SolverOptions options;
+    Fleet fleet;
+    DistanceMatrix matrix; // at least as large as the problem, the rows after the last node are unused
+    vector<SessionRoute> routes;
+    vector<int> routeOf;             // route of every customer (by ID), -1 if the customer was cancelled
+    vector<vector<int>> neighbours;  // the nearest active customers of every customer (by ID)
+    vector<int> vehiclesUsed;        // number of routes of every vehicle type
+
+    void refresh(size_t r);
+    double routeCost(const SessionRoute& route) const;
+    void checkCustomer(int id) const;
+    void growMatrix();
+    vector<int> nearestCustomers(int customer) const;
+    void addNeighbour(int customer);
+    void removeNeighbour(int customer);
+    size_t insertCustomer(int customer);
+    size_t detachCustomer(int customer);
+    void dropRoute(size_t r);
+    double replacementCost(const SessionRoute& route, size_t position, int customer) const;
+    void repair(vector<int> around, vector<size_t> touched);
+
+public:
+    /**
+     * Solves the problem with the options and starts the session with the solution.
+     * Time complexity: the chosen algorithm, then O(n^2) for the nearest neighbours
+     * @param problem the problem, it has a single depot
+     * @param options options of the solver (the algorithm, the fleet, the distances)
+     * @throws invalid_argument for multiple depots and whatever Solver::solve() throws
+     */
+    Session(const Problem& problem, const SolverOptions& options = SolverOptions());
+
+    /**
+     * Adds the customer and inserts it into the solution. A new route is opened for a customer that fits into
+     * no route, even over the limit on the number of vehicles.
+     * Time complexity: O(n * K) for K nearest neighbours (the row of the matrix and the neighbour lists), the
+     *                  matrix doubles its size when it is full
+     * @param x X coordinate of the customer
+     * @param y Y coordinate of the customer
+     * @param quantity demand of the customer
+     * @param ready the earliest start of the service
+     * @param due the latest start of the service
+     * @param service duration of the service
+     * @return ID of the customer
+     * @throws invalid_argument if the demand does not fit into any vehicle
+     * @throws logic_error if the distances were given by an explicit matrix (no distances of a new customer)
+     */
+    int addCustomer(double x, double y, double quantity, double ready = 0,
+                    double due = numeric_limits<double>::infinity(), double service = 0);
+
+    /**
+     * Cancels the customer, it is removed from its route.
+     * Time complexity: O(n * K) for the neighbour lists that contained the customer
+     * @param id ID of the customer
+     * @throws invalid_argument if there is no such active customer
+     */
+    void removeCustomer(int id);
+
+    /**
+     * Changes the demand of the customer, it is moved to another route if its route gets overloaded.
+     * Time complexity: O(n) for the insertion
+     * @param id ID of the customer
+     * @param quantity the new demand
+     * @throws invalid_argument if there is no such active customer or the demand does not fit into any vehicle
+     */
+    void changeDemand(int id, double quantity);
+
+    /**
+     * Builds the current solution.
+     * Time complexity: O(n)
+     * @return the solution with its statistics
+     */
+    Solution solution() const;
+
+    /**
+     * Retrieves the problem with all events applied, the cancelled customers included.
+     * @return the problem
+     */
+    const Problem& problem() const;
+};
+
+#endif //SESSION_HPP
@@ -0,0 +1,270 @@
+#include <regex>
+#include <stdexcept>
+#include "solver.hpp"
+#include "decomposition.hpp"
+#include "genetic.hpp"
+#include "savings.hpp"
+#include "lns.hpp"
+#include "portfolio.hpp"
+#include "random.hpp"
+#include "routeopt.hpp"
+#include "tabu.hpp"
+#include "warmstart.hpp"
+#include "sweep.hpp"
+#include "timing.hpp"
+#include "util.hpp"
+
+bool Solver::isAlgorithm(const string& algorithm) {
+    return algorithm == "savings" or algorithm == "genetic" or algorithm == "lns"
+           or algorithm == "tabu" or algorithm == "sweep" or algorithm == "portfolio";
+}
+
+DistanceMatrix Solver::distanceMatrix(const Problem& problem, const SolverOptions& options) {
+    // the rounded distances are integers, so they are stored as such (exact sums, half the memory of doubles)
+    auto precision = options.rounding != DistanceRounding::None ? MatrixPrecision::Int32 : options.matrixPrecision;
+    if (!options.distanceMatrix.empty()) {
+        return DistanceMatrix::load(options.distanceMatrix, precision, options.rounding);
+    }
+    if (!options.matrixCache.empty()) {
+        return DistanceMatrix::cached(problem.nodes, precision, options.rounding, options.matrixCache);
+    }
+    return DistanceMatrix::euclidean(problem.nodes, precision, options.rounding);
+}
+
+Fleet Solver::fleet(const Problem& problem, const SolverOptions& options) {
+    Fleet fleet = options.heterogeneousFleet ? Fleet::fromVehicles(problem.vehicles) : Fleet(problem.vehicleCapacity());
+    fleet.horizon = problem.vehicles[0].maxTravelTime;
+    fleet.timeWindows = hasTimeWindows(problem.requests) or !isinf(fleet.horizon);
+    for (size_t i = 0; i < problem.requests.size(); i++) {
+        if (problem.requests[i].quantity > fleet.maxCapacity()) {
+            throw invalid_argument("The request " + to_string(problem.requests[i].id) + " exceeds the vehicle capacity");
+        }
+    }
+    if (options.maxVehicles != 0) {
+        fleet.maxVehicles = options.maxVehicles > 0 ? options.maxVehicles : instanceVehicles(problem.name);
+        if (fleet.maxVehicles <= 0) {
+            throw invalid_argument("The number of vehicles is not part of the instance name " + problem.name);
+        }
+        int lowerBound = vehicleLowerBound(problem.requests, fleet.maxCapacity());
+        if (lowerBound > fleet.maxVehicles) {
+            throw invalid_argument("At least " + to_string(lowerBound) + " vehicles are needed, only " +
+                                   to_string(fleet.maxVehicles) + " available");
+        }
+    }
+    return fleet;
+}
+
+int Solver::instanceVehicles(const string& name) {
+    string file = name.substr(name.find_last_of('/') + 1);
+    smatch match;
+    if (regex_search(file, match, regex("-k0*([0-9]+)"))) {
+        return stoi(match[1]);
+    }
+    return 0;
+}
+
+Solution Solver::solve(const Problem& problem, const SolverOptions& options) {
+    problem.validate();
+    if (!options.decomposition.empty()) {
+        if (!options.initialRoutes.empty()) {
+            throw invalid_argument("The initial solution is not supported with the decomposition");
+        }
+        if (!isDecomposition(options.decomposition)) {
+            throw invalid_argument("Unknown decomposition " + options.decomposition);
+        }
+        if (problem.requests.size() > options.clusterSize) {
+            // the matrix of the whole problem is not needed, every cluster has its own
+            return solveDecomposed(problem, options);
+        }
+    }
+
+    PhaseTimer matrixTimer;
+    auto distanceMatrix = Solver::distanceMatrix(problem, options);
+    auto matrixTime = matrixTimer.elapsed();
+
+    Solution solution = solve(problem, options, distanceMatrix);
+    solution.matrixTime = matrixTime;
+    return solution;
+}
+
+/**
+ * Solves the problem with several depots. Every customer is assigned to its nearest depot and each depot is
+ * solved as a separate single-depot problem on its slice of the distance matrix, so the algorithms (which
+ * expect the depot at the index 0) work unchanged and every depot only sees its own customers.
+ * The routes are mapped back to the original node IDs and each route records its depot.
+ */
+static Solution solveMultiDepot(const Problem& problem, const SolverOptions& options, const DistanceMatrix& distanceMatrix) {
+    int depots = problem.depotCount();
+    vector<vector<int>> assigned(depots); // matrix indices of the customers of each depot
+    for (int customer = depots; customer < (int)problem.nodes.size(); customer++) {
+        int nearest = 0;
+        for (int depot = 1; depot < depots; depot++) {
+            if (distanceMatrix[depot][customer] < distanceMatrix[nearest][customer]) {
+                nearest = depot;
+            }
+        }
+        assigned[nearest].push_back(customer);
+    }
+
+    Solution solution;
+    solution.algorithm = options.algorithm;
+    size_t customers = 0;
+    for (int depot = 0; depot < depots; depot++) {
+        if (assigned[depot].empty()) {
+            continue;
+        }
+        // The single-depot problem of the depot, its nodes are renumbered from 1 (the depot)
+        Problem part;
+        part.name = problem.name;
+        vector<int> indices = {depot};
+        Node depotNode = problem.nodes[depot];
+        depotNode.id = 1;
+        part.nodes.push_back(depotNode);
+        for (auto& customer : assigned[depot]) {
+            Node node = problem.nodes[customer];
+            node.id = part.nodes.size() + 1;
+            part.nodes.push_back(node);
+            Request request = problem.requests[customer - depots];
+            request.whereto = node;
+            part.requests.push_back(request);
+            indices.push_back(customer);
+        }
+        // the vehicles departing from the depot, all vehicle profiles if none is based there
+        for (auto& vehicle : problem.vehicles) {
+            if (vehicle.departure.id == depot + 1) {
+                part.vehicles.push_back(vehicle);
+            }
+        }
+        if (part.vehicles.empty()) {
+            part.vehicles = problem.vehicles;
+        }
+
+        SolverOptions depotOptions = options;
+        depotOptions.seed = streamSeed(options.seed, depot);
+        Solution partial = Solver::solve(part, depotOptions, distanceMatrix.slice(indices));
+        for (auto& route : partial.routes) {
+            for (auto& customer : route) {
+                customer = indices[customer - 1] + 1; // back to the original node ID
+            }
+            solution.routes.push_back(route);
+            solution.depots.push_back(depot + 1);
+        }
+        solution.capacities.insert(solution.capacities.end(), partial.capacities.begin(), partial.capacities.end());
+        solution.distance += partial.distance;
+        solution.vehicles += partial.vehicles;
+        solution.routesWithOneCustomer += partial.routesWithOneCustomer;
+        solution.routesWithTwoCustomers += partial.routesWithTwoCustomers;
+        solution.unusedCapacity += partial.unusedCapacity;
+        solution.timeWindows = solution.timeWindows or partial.timeWindows;
+        solution.timeWarp += partial.timeWarp;
+        solution.algorithmTime += partial.algorithmTime;
+        solution.constructTime.wall += partial.constructTime.wall;
+        solution.constructTime.cpu += partial.constructTime.cpu;
+        solution.improveTime.wall += partial.improveTime.wall;
+        solution.improveTime.cpu += partial.improveTime.cpu;
+        customers += assigned[depot].size();
+    }
+    if (solution.capacities.size() != solution.routes.size()) {
+        solution.capacities.clear(); // the depots share the vehicles of the same capacity
+    }
+    solution.averageCustomers = solution.vehicles > 0 ? (double)customers / solution.vehicles : 0.0;
+    solution.instance = problem.name;
+    return solution;
+}
+
+Solution Solver::solve(const Problem& problem, const SolverOptions& options,
+                       const DistanceMatrix& distanceMatrix) {
+    if (!isAlgorithm(options.algorithm)) {
+        throw invalid_argument("Unknown algorithm " + options.algorithm);
+    }
+    problem.validate();
+    if (distanceMatrix.size() != problem.nodes.size()) {
+        throw invalid_argument("The distance matrix does not match the nodes of the problem");
+    }
+    if (problem.depotCount() > 1) {
+        if (options.maxVehicles != 0) {
+            throw invalid_argument("The limit on the number of vehicles is not supported with multiple depots");
+        }
+        if (!options.initialRoutes.empty()) {
+            throw invalid_argument("The initial solution is not supported with multiple depots");
+        }
+        return solveMultiDepot(problem, options, distanceMatrix);
+    }
+    RandomScope random(options.seed);
+
+    // unless the heterogeneous fleet is requested, the number of vehicles is not taken into account
+    // only the capacity which is taken from the first vehicle
+    Fleet fleet = Solver::fleet(problem, options);
+    // the previous solution is adapted to the customers and demands of the instance
+    vector<vector<int>> initialRoutes;
+    if (!options.initialRoutes.empty()) {
+        if (options.algorithm == "savings" or options.algorithm == "sweep") {
+            throw invalid_argument("The initial solution is used only by the genetic, lns, tabu and portfolio algorithms");
+        }
+        initialRoutes = repairRoutes(options.initialRoutes, problem.requests, fleet, distanceMatrix);
+    }
+    Solution solution;
+    if (options.algorithm == "savings") {
+        solution = savingsAlgorithm(problem.nodes, problem.requests, fleet, distanceMatrix);
+    } else if (options.algorithm == "lns") {
+        LnsOptions lnsOptions;
+        lnsOptions.timeLimit = options.timeLimit;
+        lnsOptions.initialRoutes = initialRoutes;
+        solution = lns(problem.nodes, problem.requests, fleet, distanceMatrix, lnsOptions);
+    } else if (options.algorithm == "sweep") {
+        SweepOptions sweepOptions;
+        sweepOptions.threads = max(options.threads, (size_t)1);
+        solution = sweep(problem.nodes, problem.requests, fleet, distanceMatrix, sweepOptions);
+    } else if (options.algorithm == "portfolio") {
+        PortfolioOptions portfolioOptions;
+        portfolioOptions.timeLimit = options.timeLimit;
+        portfolioOptions.initialRoutes = initialRoutes;
+        solution = portfolio(problem.nodes, problem.requests, fleet, distanceMatrix, portfolioOptions);
+    } else if (options.algorithm == "tabu") {
+        TabuOptions tabuOptions;
+        tabuOptions.timeLimit = options.timeLimit;
+        tabuOptions.initialRoutes = initialRoutes;
+        solution = tabuSearch(problem.nodes, problem.requests, fleet, distanceMatrix, tabuOptions);
+    } else {
+        GeneticOptions geneticOptions;
+        geneticOptions.initialRoutes = initialRoutes;
+        geneticOptions.threads = options.threads;
+        geneticOptions.generational = options.generational;
+        solution = genetic(problem.nodes, problem.requests, fleet, distanceMatrix, geneticOptions);
+    }
+    if (fleet.maxVehicles > 0 and (int)solution.routes.size() > fleet.maxVehicles) {
+        // the algorithms only penalize the excess vehicles, the solution must never need more trucks than exist
+        repairFleetSize(solution.routes, solution.capacities, problem.requests, fleet, distanceMatrix);
+        solution.distance = 0;
+        for (auto& route : solution.routes) {
+            solution.distance += calculateCustomerDistance(route, distanceMatrix);
+        }
+        solution.calculateStatistics(problem.requests, fleet.maxCapacity());
+    }
+    if (options.optimizeRoutes) {
+        PhaseTimer optimizeTimer;
+        optimizeRoutes(solution, problem.requests, fleet, distanceMatrix);
+        PhaseTime optimizeTime = optimizeTimer.elapsed();
+        solution.improveTime.wall += optimizeTime.wall;
+        solution.improveTime.cpu += optimizeTime.cpu;
+    }
+    if (fleet.timeWindows) {
+        solution.timeWindows = true;
+        solution.timeWarp = 0;
+        for (auto& route : solution.routes) {
+            solution.timeWarp += routeTimeWarp(route, problem.requests, fleet.horizon, distanceMatrix);
+        }
+    }
+    solution.instance = problem.name;
+    return solution;
+}
+
+Solution Solver::solveFile(const string& path, const SolverOptions& options) {
+    PhaseTimer parseTimer;
+    Problem problem = Problem::load(path);
+    auto parseTime = parseTimer.elapsed();
+
+    Solution solution = solve(problem, options);
+    solution.parseTime = parseTime;
+    return solution;
+}
@@ -0,0 +1,113 @@
+/**
+ * Public C++ API of the gal library (libgal)
+ * The problem can be built in memory or loaded from a file and solved without spawning the gal executable:
+ *
+ *     Problem problem;
+ *     problem.addDepot(0, 0);
+ *     problem.addCustomer(10, 5, 20);
+ *     problem.addVehicle(100);
+ *     Solution solution = Solver::solve(problem, SolverOptions());
+ *
+ * The solver keeps no global state, so independent problems can be solved from multiple threads at once.
+**/
+
+#ifndef SOLVER_HPP
+#define SOLVER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../structures/Problem.hpp"
+#include "../structures/Solution.hpp"
+#include "distancematrix.hpp"
+#include "fleet.hpp"
+
+using namespace std;
+
+struct SolverOptions {
+    string algorithm = "genetic"; // 'savings'|'genetic'|'lns'|'tabu'|'sweep'|'portfolio'
+    string matrixCache; // directory of the on-disk distance matrix cache, empty disables the cache
+    MatrixPrecision matrixPrecision = MatrixPrecision::Double; // type of the elements of the distance matrix
+    string distanceMatrix; // file with the explicit distance matrix used instead of the euclidean distances
+    DistanceRounding rounding = DistanceRounding::None; // rounding of the distances, stored as 32-bit integers if set
+    bool heterogeneousFleet = false; // use all vehicle profiles with their numbers instead of the first capacity only
+    double timeLimit = 0; // seconds of the search of the lns, tabu and portfolio algorithms, 0 for a fixed number of iterations
+    int maxVehicles = 0; // limit on the number of vehicles, 0 if unlimited, -1 to take k from the instance name (-kNN)
+    string decomposition; // 'sectors'|'kmeans' to solve clusters of the customers separately, empty to solve at once
+    size_t clusterSize = 200; // the largest number of customers of a cluster of the decomposition
+    bool boundaryReoptimization = false; // solve the routes along the borders of the clusters again
+    vector<vector<int>> initialRoutes; // routes of a previous solution the search starts from, see repairRoutes()
+    bool optimizeRoutes = false; // reorder the customers of every final route, exactly for short routes
+    size_t threads = 0; // worker threads solving the clusters or seeding the genetic population (0 for one per
+                        // hardware thread) or sweeping (0 for none)
+    uint64_t seed = 0; // seed of the random numbers, the same seed gives the same solution unless the search is
+                       // limited by the time limit (see random.hpp)
+    bool generational = false; // genetic breeds generations of offspring in parallel on the worker threads
+};
+
+class Solver {
+public:
+    /**
+     * Solves the problem with the algorithm chosen in the options.
+     * @param problem the problem to be solved, it is validated first
+     * @param options options of the solver
+     * @return the solution with its routes, cost and statistics
+     * @throws invalid_argument if the problem or the options are not valid
+     */
+    static Solution solve(const Problem& problem, const SolverOptions& options = SolverOptions());
+
+    /**
+     * Solves the problem using the distance matrix calculated beforehand (e.g. shared by several problems
+     * with the same nodes but different requests).
+     * @param problem the problem to be solved, it is validated first
+     * @param options options of the solver
+     * @param distanceMatrix distances between all nodes of the problem, see DistanceMatrix
+     * @return the solution of the problem
+     */
+    static Solution solve(const Problem& problem, const SolverOptions& options,
+                          const DistanceMatrix& distanceMatrix);
+
+    /**
+     * Loads the problem from the file and solves it, the time of loading is recorded in the solution.
+     * @param path path to the XML file with the problem
+     * @param options options of the solver
+     * @return the solution of the problem
+     * @throws runtime_error if the file cannot be loaded
+     */
+    static Solution solveFile(const string& path, const SolverOptions& options = SolverOptions());
+
+    /**
+     * Checks whether the algorithm is known to the solver.
+     * @param algorithm name of the algorithm
+     * @return true if the algorithm can be used in the options
+     */
+    static bool isAlgorithm(const string& algorithm);
+
+    /**
+     * Builds the distance matrix of the problem according to the options (explicit matrix, precision, on-disk cache).
+     * @param problem the problem the matrix is built for
+     * @param options options of the solver
+     * @return the distance matrix
+     */
+    static DistanceMatrix distanceMatrix(const Problem& problem, const SolverOptions& options);
+
+    /**
+     * Builds the fleet of the problem according to the options, either the unlimited vehicles with the capacity
+     * of the first profile (uniform) or all the vehicle profiles with their numbers (heterogeneous).
+     * @param problem the problem the fleet is built for
+     * @param options options of the solver
+     * @return the fleet
+     * @throws invalid_argument if a request does not fit into any vehicle or the limit on the number of vehicles
+     *                           is lower than the bin packing lower bound
+     */
+    static Fleet fleet(const Problem& problem, const SolverOptions& options);
+
+    /**
+     * Finds the number of vehicles encoded in the name of the instance (e.g. 5 for data/A-n32-k05.xml).
+     * @param name name of the instance
+     * @return the number of vehicles, 0 if the name does not contain it
+     */
+    static int instanceVehicles(const string& name);
+};
+
+#endif //SOLVER_HPP
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include "sweep.hpp"
+#include "savings.hpp"
+#include "threadpool.hpp"
+#include "timing.hpp"
+
+vector<int> angularOrder(const vector<Node>& nodes) {
+    size_t n = nodes.size() - 1;
+    vector<double> dx(n), dy(n), keys(n);
+    for (size_t i = 0; i < n; i++) {
+        dx[i] = nodes[i+1].x - nodes[0].x;
+        dy[i] = nodes[i+1].y - nodes[0].y;
+    }
+    // pseudo-angle in [0, 4), it grows with the angle, the quadrants are [0, 1), [1, 2), [2, 3) and [3, 4)
+    for (size_t i = 0; i < n; i++) {
+        double sum = fabs(dx[i]) + fabs(dy[i]);
+        double p = sum > 0 ? dy[i] / sum : 0;
+        keys[i] = dx[i] < 0 ? 2 - p : (dy[i] < 0 ? 4 + p : p);
+    }
+    vector<int> order(n);
+    iota(order.begin(), order.end(), 2); // customer IDs start at 2
+    sort(order.begin(), order.end(), [&](int a, int b) {
+        return keys[a-2] < keys[b-2] or (keys[a-2] == keys[b-2] and a < b);
+    });
+    return order;
+}
+
+/**
+ * Collects the customers into routes in the given order starting at the given position
+ * Time complexity: O(n)
+ * Space complexity: O(n)
+ * @param direction 1 to sweep counterclockwise, -1 clockwise
+*/
+static vector<Route> sweepFrom(const vector<int>& order, size_t start, int direction, const vector<Request>& requests,
+                               const Fleet& fleet, const DistanceMatrix& distanceMatrix) {
+    vector<Route> routes;
+    vector<int> vehiclesUsed(fleet.types.size(), 0);
+    // the route is built for the largest vehicle still available, a smaller one is assigned when it is complete,
+    // if the customer opening the route does not fit into it, the smallest vehicle that holds the customer is used
+    // (over its count if there is none left, the excess vehicles are penalized by the other algorithms too)
+    auto openRoute = [&](int customer) {
+        double demand = requests[customer-2].quantity;
+        int type = fleet.largestAvailable(vehiclesUsed);
+        if (fleet.types[type].capacity < demand) {
+            type = fleet.smallestAvailable(demand, vehiclesUsed);
+        }
+        if (type < 0) {
+            throw invalid_argument("The demand of the customer " + to_string(customer) + " exceeds the capacity of every vehicle");
+        }
+        return Route(fleet.types[type].capacity, fleet.horizon);
+    };
+    auto closeRoute = [&](Route& route) {
+        route.addDistancesToDepot(distanceMatrix);
+        int type = fleet.smallestAvailable(route.currentQuantity, vehiclesUsed);
+        vehiclesUsed[type]++;
+        route.vehicleCapacity = fleet.types[type].capacity;
+        routes.push_back(route);
+    };
+
+    size_t n = order.size();
+    Route route(0, fleet.horizon); // an empty route holding nobody, the first customer opens a new one
+    for (size_t k = 0; k < n; k++) {
+        int customer = order[direction > 0 ? (start + k) % n : (start + n - k) % n];
+        if (!route.addCustomerIfCapacity(customer, requests, false, distanceMatrix)) {
+            if (route.getSize() > 0) {
+                closeRoute(route);
+            }
+            route = openRoute(customer);
+            if (!route.addCustomerIfCapacity(customer, requests, false, distanceMatrix)) {
+                throw logic_error("The customer " + to_string(customer) + " does not fit into an empty route");
+            }
+        }
+    }
+    if (route.getSize() > 0) {
+        closeRoute(route);
+    }
+    return routes;
+}
+
+Solution sweep(const vector<Node>& nodes, const vector<Request>& requests, const Fleet& fleet,
+               const DistanceMatrix& distanceMatrix, const SweepOptions& options) {
+    // TIMESTAMP: Record time before the algorithm starts
+    auto algorithmStart = chrono::high_resolution_clock::now();
+    PhaseTimer constructTimer;
+
+    vector<int> order = angularOrder(nodes);
+    size_t starts = max(min(options.starts, order.size()), (size_t)1);
+    vector<vector<Route>> sweeps(2 * starts);
+    auto run = [&](size_t k) {
+        sweeps[k] = sweepFrom(order, k / 2 * order.size() / starts, k % 2 == 0 ? 1 : -1, requests, fleet, distanceMatrix);
+    };
+    if (options.threads > 1 and sweeps.size() > 1) {
+        ThreadPool pool(min(options.threads, sweeps.size()));
+        for (size_t k = 0; k < sweeps.size(); k++) {
+            pool.submit([&, k]() { run(k); });
+        }
+        pool.wait();
+    } else {
+        for (size_t k = 0; k < sweeps.size(); k++) {
+            run(k);
+        }
+    }
+
+    // the shortest sweep, the first one on a tie, so the result does not depend on the threads
+    auto length = [](const vector<Route>& routes) {
+        double distance = 0;
+        for (auto& route : routes) {
+            distance += route.distance;
+        }
+        return distance;
+    };
+    size_t best = 0;
+    for (size_t k = 1; k < sweeps.size(); k++) {
+        if (length(sweeps[k]) < length(sweeps[best])) {
+            best = k;
+        }
+    }
+
+    // TIMESTAMP: record the time after the algorithm ends and calculate its duration
+    auto algorithmEnd = chrono::high_resolution_clock::now();
+    auto algorithmDuration = chrono::duration_cast<chrono::microseconds>(algorithmEnd - algorithmStart);
+    auto constructTime = constructTimer.elapsed();
+
+    Solution solution;
+    solution.algorithm = "sweep";
+    for (auto& route : sweeps[best]) {
+        solution.distance += route.distance;
+        solution.routes.push_back(route.getCustomers());
+        if (!fleet.isUniform()) {
+            solution.capacities.push_back(route.vehicleCapacity);
+        }
+    }
+    solution.algorithmTime = algorithmDuration.count();
+    solution.constructTime = constructTime;
+    solution.calculateStatistics(requests, fleet.maxCapacity());
+
+    return solution;
+}
@@ -0,0 +1,51 @@
+/**
+ * Sweep algorithm
+ * Based on Gillett and Miller, A heuristic algorithm for the vehicle-dispatch problem, 1974. The customers are
+ * ordered by their angle around the depot and a ray sweeping around the depot collects them into routes, a route
+ * is closed when the next customer does not fit (capacity or time windows). The sweep is repeated from several
+ * start angles in both directions and the shortest result is kept. There is no improvement phase, the algorithm
+ * is meant as a very fast baseline and a seed for the other algorithms.
+ * The angle is replaced by the pseudo-angle dy / (|dx| + |dy|) which orders the customers the same way without
+ * the trigonometric functions, it is calculated in a branch-free loop the compiler vectorizes.
+**/
+
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include "../structures/DataReader.hpp"
+#include "../structures/Solution.hpp"
+#include "distancematrix.hpp"
+#include "fleet.hpp"
+
+using namespace std;
+
+struct SweepOptions {
+    size_t starts = 8;  // number of start angles (evenly spaced in the order of the customers), each in both directions
+    size_t threads = 1; // worker threads sweeping from different starts, 1 to sweep in the calling thread
+};
+
+/**
+ * Runs the sweep algorithm.
+ * Time complexity: O(n log n + s * n) for n customers and s starts
+ * Space complexity: O(n)
+ * @param nodes nodes of the problem, the depot first
+ * @param requests requests of the customers, customer with ID i has the request i-2
+ * @param fleet the available vehicles (a route is built for the largest available one, the smallest that fits
+ *              is assigned to it as in savingsAlgorithm())
+ * @param distanceMatrix distances between all nodes
+ * @param options parameters of the sweep
+ * @return the shortest of the sweeps
+ */
+Solution sweep(const vector<Node>& nodes, const vector<Request>& requests, const Fleet& fleet,
+               const DistanceMatrix& distanceMatrix, const SweepOptions& options = SweepOptions());
+
+/**
+ * Orders the customers by their angle around the depot.
+ * Time complexity: O(n log n)
+ * Space complexity: O(n)
+ * @param nodes nodes of the problem, the depot first
+ * @return customer IDs ordered counterclockwise
+ */
+vector<int> angularOrder(const vector<Node>& nodes);
+
+#endif //SWEEP_HPP
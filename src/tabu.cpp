@@ -0,0 +1,536 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include "tabu.hpp"
+#include "genetic.hpp"
+#include "savings.hpp"
+#include "timewindows.hpp"
+#include "timing.hpp"
+
+namespace {
+    // Route of the search, the prefix loads and the timing segments make every move O(1) to evaluate
+    struct TabuRoute {
+        vector<int> customers;
+        vector<double> prefixLoad; // prefixLoad[i] is the load of the first i customers
+        double load = 0;
+        double distance = 0;
+        double timeWarp = 0;
+        optional<RouteTimeWindows> timing; // only with time windows
+    };
+
+    enum class MoveType { Relocate, Swap, TwoOptStar };
+
+    struct TabuMove {
+        MoveType type = MoveType::Relocate;
+        int u = 0;          // customer moved by the move
+        int v = 0;          // relocate: customer after which u is inserted (0 for the start of the route),
+                            // swap: customer exchanged with u, 2-opt*: customer starting the end joined after u
+        int route = 0;      // route receiving u (relocate only)
+        double delta = numeric_limits<double>::infinity(); // change of the cost
+        double overload = 0; // change of the load over the capacity
+    };
+
+    /**
+     * Attributes (customer, route) of the recent moves with the iteration until which the customer may not be
+     * placed into the route, stored in a flat open addressing table. Expired entries are dropped when it fills up.
+     */
+    class TabuList {
+    private:
+        static constexpr uint64_t EMPTY = ~0ULL;
+        vector<uint64_t> keys;
+        vector<size_t> expiries;
+        size_t used = 0;
+        int bits = 10;
+
+        static uint64_t key(int customer, int route) {
+            return (uint64_t)customer << 32 | (uint32_t)route;
+        }
+
+        size_t find(uint64_t key) const {
+            size_t mask = keys.size() - 1;
+            size_t slot = (key * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+            while (keys[slot] != EMPTY and keys[slot] != key) {
+                slot = (slot + 1) & mask;
+            }
+            return slot;
+        }
+
+        void rebuild(size_t iteration) {
+            vector<uint64_t> oldKeys = move(keys);
+            vector<size_t> oldExpiries = move(expiries);
+            size_t alive = count_if(oldExpiries.begin(), oldExpiries.end(), [&](size_t e) { return e > iteration; });
+            if (alive * 4 > oldKeys.size()) {
+                bits++;
+            }
+            keys.assign((size_t)1 << bits, EMPTY);
+            expiries.assign(keys.size(), 0);
+            used = 0;
+            for (size_t i = 0; i < oldKeys.size(); i++) {
+                if (oldKeys[i] != EMPTY and oldExpiries[i] > iteration) {
+                    size_t slot = find(oldKeys[i]);
+                    keys[slot] = oldKeys[i];
+                    expiries[slot] = oldExpiries[i];
+                    used++;
+                }
+            }
+        }
+
+    public:
+        TabuList() : keys((size_t)1 << 10, EMPTY), expiries(keys.size(), 0) {}
+
+        void forbid(int customer, int route, size_t until, size_t iteration) {
+            size_t slot = find(key(customer, route));
+            if (keys[slot] == EMPTY) {
+                keys[slot] = key(customer, route);
+                used++;
+            }
+            expiries[slot] = until;
+            if (used * 2 > keys.size()) {
+                rebuild(iteration);
+            }
+        }
+
+        bool forbidden(int customer, int route, size_t iteration) const {
+            size_t slot = find(key(customer, route));
+            return keys[slot] != EMPTY and expiries[slot] > iteration;
+        }
+    };
+
+    struct TabuState {
+        vector<TabuRoute> routes;   // the indices are stable, emptied routes stay in place
+        vector<int> routeOf;        // route of every customer (by ID)
+        vector<int> positionOf;     // position of every customer in its route (by ID)
+        vector<size_t> moves;       // how many times every customer was moved (by ID)
+        double overload = 0;        // load over the capacity summed over the routes
+        double overloadPenalty = 0; // penalty of a unit of the overload, adapted during the search
+        double cost = 0;            // distance with the penalties of the time warp, overload and excess vehicles
+    };
+
+    /**
+     * The best move found so far, the moves making the solution worse are penalized by how often their customer
+     * was already moved, so the search does not keep shuffling the same customers (Cordeau, Gendreau and Laporte,
+     * A tabu search heuristic for periodic and multi-depot vehicle routing problems, 1997)
+     */
+    struct MoveSelection {
+        TabuMove best;
+        double value = numeric_limits<double>::infinity(); // the penalized delta of the best move
+        double aspiration;  // tabu moves are allowed if they lead to a solution cheaper than this
+        double penalty;     // penalty of a worsening move for every previous move of its customer
+        double closing = 0; // reward of a move emptying a route while more vehicles are used than available
+
+        void offer(const TabuMove& move, bool admissible, const TabuState& state) {
+            double moveValue = move.delta > 0 ? move.delta + penalty * state.moves[move.u] : move.delta;
+            bool improving = state.cost + move.delta < aspiration and state.overload + move.overload < 1e-9;
+            if (moveValue < value and (admissible or improving)) {
+                best = move;
+                value = moveValue;
+            }
+        }
+    };
+
+    struct TabuContext {
+        const vector<Request>& requests;
+        const Fleet& fleet;
+        const DistanceMatrix& distanceMatrix;
+        const TabuOptions& options;
+        vector<vector<int>> candidates; // the close customers of every customer (by ID), the granular neighbourhood
+        double capacity;
+        double vehiclePenalty = 0; // penalty of every vehicle used over the available count
+    };
+}
+
+// Recalculates the cached values of the route after it was modified
+static void refresh(TabuState& state, int r, const TabuContext& context) {
+    auto& matrix = context.distanceMatrix;
+    auto& route = state.routes[r];
+    route.prefixLoad.assign(1, 0);
+    route.distance = 0;
+    int previous = 0;
+    for (size_t i = 0; i < route.customers.size(); i++) {
+        int customer = route.customers[i];
+        route.prefixLoad.push_back(route.prefixLoad.back() + context.requests[customer-2].quantity);
+        route.distance += matrix[previous][customer-1];
+        previous = customer - 1;
+        state.routeOf[customer] = r;
+        state.positionOf[customer] = i;
+    }
+    route.distance += matrix[previous][0];
+    route.load = route.prefixLoad.back();
+    if (context.fleet.timeWindows) {
+        route.timing.emplace(route.customers, context.requests, context.fleet.horizon, matrix);
+        route.timeWarp = route.timing->timeWarp();
+    }
+}
+
+// Replaces the routes of the state, an empty route is kept at the end for the moves opening a new route
+static void loadRoutes(TabuState& state, const vector<vector<int>>& routes, const TabuContext& context) {
+    state.routes.clear();
+    for (auto& customers : routes) {
+        state.routes.push_back(TabuRoute());
+        state.routes.back().customers = customers;
+        refresh(state, state.routes.size() - 1, context);
+    }
+    state.routes.push_back(TabuRoute());
+    refresh(state, state.routes.size() - 1, context);
+}
+
+static double usedRoutes(const TabuState& state) {
+    return count_if(state.routes.begin(), state.routes.end(), [](const TabuRoute& route) { return !route.customers.empty(); });
+}
+
+// Load of the route over the capacity of the vehicle
+static double overload(double load, const TabuContext& context) {
+    return max(load - context.capacity, 0.0);
+}
+
+// Distance of the route with the penalties of its time warp and overload
+static double routeCost(const TabuRoute& route, const TabuState& state, const TabuContext& context) {
+    return route.distance + route.timeWarp * TIME_WARP_PENALTY + overload(route.load, context) * state.overloadPenalty;
+}
+
+/**
+ * Recalculates the cost of the state, needed whenever the penalty of the overload changes
+ * Time complexity: O(R) for R routes
+*/
+static void updateCost(TabuState& state, const TabuContext& context) {
+    state.cost = 0;
+    state.overload = 0;
+    for (auto& route : state.routes) {
+        state.cost += routeCost(route, state, context);
+        state.overload += overload(route.load, context);
+    }
+    if (context.fleet.maxVehicles >= 0) {
+        // the vehicles used over the available count
+        state.cost += max(usedRoutes(state) - context.fleet.maxVehicles, 0.0) * context.vehiclePenalty;
+    }
+}
+
+// Matrix index of the node at the position of the route, the depot before the first and after the last customer
+static int nodeAt(const TabuRoute& route, int position) {
+    return position < 0 or position >= (int)route.customers.size() ? 0 : route.customers[position] - 1;
+}
+
+/**
+ * Evaluates the relocation of the customer u between the nodes a and b (matrix indices) of the route r,
+ * b is at the given position of the route
+ * Time complexity: O(1), O(R) for a move inside a route with time windows
+*/
+static void evaluateRelocate(const TabuState& state, const TabuContext& context, int u, int r, size_t position,
+                             MoveSelection& selection, bool admissible) {
+    auto& matrix = context.distanceMatrix;
+    auto& from = state.routes[state.routeOf[u]];
+    auto& to = state.routes[r];
+    int i = state.positionOf[u];
+    int a = nodeAt(to, (int)position - 1);
+    int b = nodeAt(to, position);
+    bool sameRoute = state.routeOf[u] == r;
+    if (sameRoute and (a == u - 1 or b == u - 1)) {
+        return; // the customer would stay in its place
+    }
+    int p = nodeAt(from, i - 1);
+    int n = nodeAt(from, i + 1);
+    double delta = matrix[p][n] - matrix[p][u-1] - matrix[u-1][n] + matrix[a][u-1] + matrix[u-1][b] - matrix[a][b];
+    double overloadChange = 0;
+    if (!sameRoute) {
+        double quantity = context.requests[u-2].quantity;
+        overloadChange = overload(from.load - quantity, context) - overload(from.load, context)
+                         + overload(to.load + quantity, context) - overload(to.load, context);
+        delta += overloadChange * state.overloadPenalty;
+    }
+    if (from.customers.size() == 1 and !to.customers.empty()) {
+        delta -= selection.closing;
+    }
+    if (context.fleet.timeWindows) {
+        if (sameRoute) {
+            // the prefix and suffix segments do not cover a reordered route, it is simulated again
+            vector<int> customers = from.customers;
+            customers.erase(customers.begin() + i);
+            customers.insert(customers.begin() + (position > (size_t)i ? position - 1 : position), u);
+            double timeWarp = routeTimeWarp(customers, context.requests, context.fleet.horizon, matrix);
+            delta += (timeWarp - from.timeWarp) * TIME_WARP_PENALTY;
+        } else {
+            delta += (from.timing->removalTimeWarp(i) - from.timeWarp
+                      + to.timing->insertionTimeWarp(position, u) - to.timeWarp) * TIME_WARP_PENALTY;
+        }
+    }
+    selection.offer(TabuMove{MoveType::Relocate, u, position == 0 ? 0 : to.customers[position-1], r, delta,
+                             overloadChange}, admissible, state);
+}
+
+/**
+ * Finds the best move of the granular neighbourhood that is not tabu, or leads to a better solution than the best one
+ * Time complexity: O(n * K) for n customers and K candidates of every customer
+ * Space complexity: O(1)
+*/
+static TabuMove bestMove(const TabuState& state, const TabuContext& context, const TabuList& tabu,
+                         size_t iteration, double aspiration, double penalty) {
+    auto& matrix = context.distanceMatrix;
+    auto& requests = context.requests;
+    bool timeWindows = context.fleet.timeWindows;
+    MoveSelection selection;
+    selection.aspiration = aspiration;
+    selection.penalty = penalty;
+
+    // a new route may be opened by a relocation, unless all vehicles are already used
+    int emptyRoute = -1;
+    int usedRoutes = 0;
+    for (size_t r = 0; r < state.routes.size(); r++) {
+        if (state.routes[r].customers.empty()) {
+            emptyRoute = emptyRoute == -1 ? r : emptyRoute;
+        } else {
+            usedRoutes++;
+        }
+    }
+    if (context.fleet.maxVehicles >= 0 and usedRoutes >= context.fleet.maxVehicles) {
+        emptyRoute = -1;
+        selection.closing = usedRoutes > context.fleet.maxVehicles ? context.vehiclePenalty : 0;
+    }
+
+    for (int u = 2; u < (int)state.routeOf.size(); u++) {
+        int r1 = state.routeOf[u];
+        auto& route1 = state.routes[r1];
+        int i = state.positionOf[u];
+        double quantityU = requests[u-2].quantity;
+
+        if (emptyRoute != -1 and route1.customers.size() > 1) {
+            evaluateRelocate(state, context, u, emptyRoute, 0, selection, !tabu.forbidden(u, emptyRoute, iteration));
+        }
+        for (auto& v : context.candidates[u]) {
+            int r2 = state.routeOf[v];
+            auto& route2 = state.routes[r2];
+            int j = state.positionOf[v];
+            bool admissible = !tabu.forbidden(u, r2, iteration);
+
+            // relocate u after v and before v, both create the edge between them
+            evaluateRelocate(state, context, u, r2, j + 1, selection, admissible);
+            evaluateRelocate(state, context, u, r2, j, selection, admissible);
+            if (r1 == r2) {
+                continue;
+            }
+
+            // swap u with the customer following v, u gets next to v
+            if (j + 1 < (int)route2.customers.size()) {
+                int w = route2.customers[j+1];
+                double quantityW = requests[w-2].quantity;
+                int p1 = nodeAt(route1, i - 1), n1 = nodeAt(route1, i + 1), n2 = nodeAt(route2, j + 2);
+                double delta = matrix[p1][w-1] + matrix[w-1][n1] - matrix[p1][u-1] - matrix[u-1][n1]
+                               + matrix[v-1][u-1] + matrix[u-1][n2] - matrix[v-1][w-1] - matrix[w-1][n2];
+                double overloadChange = overload(route1.load - quantityU + quantityW, context) - overload(route1.load, context)
+                                        + overload(route2.load - quantityW + quantityU, context) - overload(route2.load, context);
+                delta += overloadChange * state.overloadPenalty;
+                if (timeWindows) {
+                    delta += (route1.timing->replacementTimeWarp(i, w) - route1.timeWarp
+                              + route2.timing->replacementTimeWarp(j + 1, u) - route2.timeWarp) * TIME_WARP_PENALTY;
+                }
+                bool swapAdmissible = admissible and !tabu.forbidden(w, r1, iteration);
+                selection.offer(TabuMove{MoveType::Swap, u, w, r2, delta, overloadChange}, swapAdmissible, state);
+            }
+
+            // 2-opt*, the route of u continues with v and the rest of its route, the other route takes the rest
+            // of the route of u
+            double loadA = route1.prefixLoad[i+1] + route2.load - route2.prefixLoad[j];
+            double loadB = route2.prefixLoad[j] + route1.load - route1.prefixLoad[i+1];
+            int n1 = nodeAt(route1, i + 1), p2 = nodeAt(route2, j - 1);
+            double delta = matrix[u-1][v-1] + matrix[p2][n1] - matrix[u-1][n1] - matrix[p2][v-1];
+            double overloadChange = overload(loadA, context) - overload(route1.load, context)
+                                    + overload(loadB, context) - overload(route2.load, context);
+            delta += overloadChange * state.overloadPenalty;
+            if (j == 0 and n1 == 0) {
+                delta -= selection.closing; // the routes are joined
+            }
+            if (timeWindows) {
+                delta += (route1.timing->exchangeTimeWarp(i + 1, *route2.timing, j) - route1.timeWarp
+                          + route2.timing->exchangeTimeWarp(j, *route1.timing, i + 1) - route2.timeWarp)
+                         * TIME_WARP_PENALTY;
+            }
+            bool exchangeAdmissible = !tabu.forbidden(v, r1, iteration)
+                                      and (n1 == 0 or !tabu.forbidden(n1 + 1, r2, iteration));
+            selection.offer(TabuMove{MoveType::TwoOptStar, u, v, r2, delta, overloadChange}, exchangeAdmissible, state);
+        }
+    }
+    return selection.best;
+}
+
+// Applies the move and forbids the moved customers to return to the routes they left
+static void applyMove(TabuState& state, const TabuMove& move, const TabuContext& context, TabuList& tabu,
+                      size_t iteration) {
+    size_t until = iteration + context.options.tenure + 1;
+    state.moves[move.u]++;
+    int r1 = state.routeOf[move.u];
+    int i = state.positionOf[move.u];
+    int r2 = move.type == MoveType::Relocate ? move.route : state.routeOf[move.v];
+    auto& route1 = state.routes[r1].customers;
+    auto& route2 = state.routes[r2].customers;
+
+    if (move.type == MoveType::Relocate) {
+        route1.erase(route1.begin() + i);
+        auto position = move.v == 0 ? route2.begin() : find(route2.begin(), route2.end(), move.v) + 1;
+        route2.insert(position, move.u);
+        tabu.forbid(move.u, r1, until, iteration);
+    } else if (move.type == MoveType::Swap) {
+        swap(route1[i], route2[state.positionOf[move.v]]);
+        tabu.forbid(move.u, r1, until, iteration);
+        tabu.forbid(move.v, r2, until, iteration);
+    } else {
+        int j = state.positionOf[move.v];
+        if (i + 1 < (int)route1.size()) {
+            tabu.forbid(route1[i+1], r1, until, iteration);
+        }
+        tabu.forbid(move.v, r2, until, iteration);
+        vector<int> tail1(route1.begin() + i + 1, route1.end());
+        route1.resize(i + 1);
+        route1.insert(route1.end(), route2.begin() + j, route2.end());
+        route2.resize(j);
+        route2.insert(route2.end(), tail1.begin(), tail1.end());
+    }
+    refresh(state, r1, context);
+    if (r1 != r2) {
+        refresh(state, r2, context);
+    }
+
+    // an empty route is always available for the relocations opening a new route
+    if (none_of(state.routes.begin(), state.routes.end(), [](const TabuRoute& route) { return route.customers.empty(); })) {
+        state.routes.push_back(TabuRoute());
+        refresh(state, state.routes.size() - 1, context);
+    }
+}
+
+Solution tabuSearch(const vector<Node>& nodes, const vector<Request>& requests, const Fleet& fleet,
+                    const DistanceMatrix& distanceMatrix, const TabuOptions& options) {
+    // TIMESTAMP: Record time before the algorithm starts
+    auto algorithmStart = chrono::high_resolution_clock::now();
+
+    PhaseTimer constructTimer;
+    TabuContext context{requests, fleet, distanceMatrix, options, vector<vector<int>>(nodes.size() + 1), fleet.maxCapacity()};
+
+    // The savings solution is the starting point, unless an initial solution is given or another engine has
+    // already published a solution
+    const IncumbentSolution* shared = options.incumbent != nullptr ? options.incumbent->best() : nullptr;
+    vector<vector<int>> initial = shared != nullptr ? shared->routes
+                                  : !options.initialRoutes.empty() ? options.initialRoutes
+                                  : savingsAlgorithm(nodes, requests, fleet, distanceMatrix).routes;
+    double initialDistance = 0;
+    for (auto& route : initial) {
+        initialDistance += calculateCustomerDistance(route, distanceMatrix);
+    }
+    TabuState current;
+    current.routeOf.assign(nodes.size() + 1, -1);
+    current.positionOf.assign(nodes.size() + 1, -1);
+    current.moves.assign(nodes.size() + 1, 0);
+    loadRoutes(current, initial, context);
+    vector<int> tour;
+    double demand = 0;
+    for (size_t customer = 2; customer <= nodes.size(); customer++) {
+        tour.push_back(customer);
+        demand += requests[customer-2].quantity;
+    }
+    if (fleet.maxVehicles >= 0) {
+        context.vehiclePenalty = excessVehiclePenalty(tour, distanceMatrix);
+    }
+
+    // The granular neighbourhood keeps the nearest customers closer than a multiple of the average edge
+    // of the initial solution (the nearest one is always kept so that no customer is left without moves)
+    double customers = nodes.size() - 1;
+    double averageEdge = initialDistance / (customers + initial.size());
+    double threshold = options.granularity * averageEdge;
+    for (size_t customer = 2; customer <= nodes.size(); customer++) {
+        auto& candidates = context.candidates[customer];
+        for (size_t other = 2; other <= nodes.size(); other++) {
+            if (other != customer) {
+                candidates.push_back(other);
+            }
+        }
+        auto closer = [&](int a, int b) {
+            return distanceMatrix[customer-1][a-1] < distanceMatrix[customer-1][b-1]
+                   or (distanceMatrix[customer-1][a-1] == distanceMatrix[customer-1][b-1] and a < b);
+        };
+        size_t count = min(options.neighbours, candidates.size());
+        partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), closer);
+        candidates.resize(count);
+        while (candidates.size() > 1 and distanceMatrix[customer-1][candidates.back()-1] > threshold) {
+            candidates.pop_back();
+        }
+    }
+    // an overloaded route may be used on the way, the penalty of the overload starts at the cost of an average edge
+    // per an average demand
+    double initialPenalty = demand > 0 ? averageEdge * customers / demand : 1;
+    current.overloadPenalty = initialPenalty;
+    updateCost(current, context);
+    vector<vector<int>> best = initial;
+    double bestCost = current.cost;
+    double publishedCost = shared != nullptr ? shared->cost : numeric_limits<double>::infinity();
+    auto constructTime = constructTimer.elapsed();
+
+    // The best admissible move is applied in every iteration, even if the solution gets worse
+    PhaseTimer improveTimer;
+    TabuList tabu;
+    auto searchStart = chrono::steady_clock::now();
+    for (size_t iteration = 0; ; iteration++) {
+        if (options.timeLimit > 0) {
+            if (chrono::duration<double>(chrono::steady_clock::now() - searchStart).count() >= options.timeLimit) {
+                break;
+            }
+        } else if (iteration >= options.iterations) {
+            break;
+        }
+        // the frequency penalty grows with the size of the problem as in the paper of Cordeau et al.
+        double penalty = options.diversification * current.cost * sqrt(customers * usedRoutes(current)) / (iteration + 1);
+        TabuMove move = bestMove(current, context, tabu, iteration, bestCost - 1e-9, penalty);
+        if (move.delta == numeric_limits<double>::infinity()) {
+            break; // every move is tabu
+        }
+        applyMove(current, move, context, tabu, iteration);
+
+        // the penalty grows while the routes are overloaded and falls while they are not (Cordeau et al.)
+        current.overloadPenalty *= current.overload > 1e-9 ? 1 + options.overloadAdaptation
+                                                           : 1 / (1 + options.overloadAdaptation);
+        current.overloadPenalty = max(current.overloadPenalty, initialPenalty * 1e-3);
+        updateCost(current, context);
+        if (current.overload < 1e-9 and current.cost < bestCost - 1e-9) {
+            bestCost = current.cost;
+            best.clear();
+            for (auto& route : current.routes) {
+                if (!route.customers.empty()) {
+                    best.push_back(route.customers);
+                }
+            }
+        }
+
+        if (options.incumbent != nullptr and iteration % options.exchangeInterval == 0) {
+            // the improvement is published, the search continues from a better solution of another engine
+            double cost = options.incumbent->cost(best);
+            if (cost < publishedCost - 1e-9) {
+                options.incumbent->offer(best, "tabu");
+                publishedCost = cost;
+            }
+            shared = options.incumbent->best();
+            if (shared != nullptr and shared->cost < publishedCost - 1e-9) {
+                best = shared->routes;
+                loadRoutes(current, best, context);
+                updateCost(current, context);
+                bestCost = current.cost;
+                publishedCost = shared->cost;
+            }
+        }
+    }
+    if (options.incumbent != nullptr) {
+        options.incumbent->offer(best, "tabu");
+    }
+    auto improveTime = improveTimer.elapsed();
+
+    // TIMESTAMP: record the time after the algorithm ends and calculate its duration
+    auto algorithmEnd = chrono::high_resolution_clock::now();
+    auto algorithmDuration = chrono::duration_cast<chrono::microseconds>(algorithmEnd - algorithmStart);
+
+    Solution solution;
+    solution.algorithm = "tabu";
+    assignVehicles(solution, best, requests, fleet, distanceMatrix);
+    solution.algorithmTime = algorithmDuration.count();
+    solution.constructTime = constructTime;
+    solution.improveTime = improveTime;
+    solution.calculateStatistics(requests, fleet.maxCapacity());
+
+    return solution;
+}
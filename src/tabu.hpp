@@ -0,0 +1,54 @@
+/**
+ * Granular tabu search
+ * Based on Toth and Vigo, The granular tabu search and its application to the vehicle-routing problem, 2003.
+ * Only the moves creating a short edge (to one of the nearest customers, not longer than a multiple of the average
+ * edge) are evaluated: relocate, swap and 2-opt* between routes. Every move is evaluated in O(1) from the cached
+ * loads (prefix sums) and time-window segments of the routes. The best admissible move is applied in every
+ * iteration even if it makes the solution worse, the customers moved out of a route may not return to it for
+ * a few iterations (tabu), unless the move leads to a new best solution (aspiration). As in Cordeau, Gendreau and
+ * Laporte (1997), overloaded routes are allowed with an adaptive penalty and the worsening moves of frequently
+ * moved customers are penalized.
+ * The search has no randomness, the same input always gives the same solution (unless it exchanges solutions
+ * with other engines through a shared incumbent in the portfolio).
+**/
+
+#ifndef TABU_HPP
+#define TABU_HPP
+
+#include "../structures/DataReader.hpp"
+#include "../structures/Solution.hpp"
+#include "distancematrix.hpp"
+#include "fleet.hpp"
+#include "incumbent.hpp"
+
+using namespace std;
+
+struct TabuOptions {
+    double timeLimit = 0;       // seconds of the search, 0 to stop after the iterations instead
+    size_t iterations = 5000;   // number of iterations if there is no time limit
+    size_t neighbours = 20;     // the nearest customers of every customer considered by the moves
+    double granularity = 2.0;   // the longest edge created by a move as a multiple of the average edge
+    size_t tenure = 10;         // number of iterations a customer may not return to the route it left
+    double diversification = 0.015; // weight of the penalty of the worsening moves of frequently moved customers
+    double overloadAdaptation = 0.5; // relative change of the penalty of the overload in every iteration
+    vector<vector<int>> initialRoutes; // starting solution instead of the savings one, it must be feasible
+    Incumbent* incumbent = nullptr; // best solution shared with other engines, nullptr to search alone
+    size_t exchangeInterval = 100;  // iterations between the exchanges with the incumbent
+};
+
+/**
+ * Runs the granular tabu search starting from the savings solution (or the initial solution or the incumbent).
+ * Time complexity: O(i * (n * K + R)) for i iterations, n customers, K neighbours and the length R of a route
+ *                  (the applied move updates the data of the two routes involved)
+ * Space complexity: O(n * K)
+ * @param nodes nodes of the problem, the depot first
+ * @param requests requests of the customers, customer with ID i has the request i-2
+ * @param fleet the available vehicles (routes are built for the largest one, then split for the fleet)
+ * @param distanceMatrix distances between all nodes
+ * @param options parameters of the search
+ * @return the best solution found
+ */
+Solution tabuSearch(const vector<Node>& nodes, const vector<Request>& requests, const Fleet& fleet,
+                    const DistanceMatrix& distanceMatrix, const TabuOptions& options = TabuOptions());
+
+#endif //TABU_HPP
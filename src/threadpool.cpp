@@ -0,0 +1,133 @@
+#include "threadpool.hpp"
+#include "timing.hpp"
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.push_back(make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        this->threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        lock_guard<mutex> guard(stateLock);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : threads) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+void ThreadPool::submit(function<void()> task, double weight) {
+    // Pick the worker with the least pending work
+    size_t target = 0;
+    double lowestWeight = -1;
+    for (size_t i = 0; i < workers.size(); i++) {
+        lock_guard<mutex> guard(workers[i]->lock);
+        if (lowestWeight < 0 or workers[i]->pendingWeight < lowestWeight) {
+            lowestWeight = workers[i]->pendingWeight;
+            target = i;
+        }
+    }
+
+    {
+        lock_guard<mutex> guard(stateLock);
+        queued++;
+        unfinished++;
+    }
+    {
+        // Keep the deque sorted so that the owner starts with the heaviest task and thieves take the lightest one
+        lock_guard<mutex> guard(workers[target]->lock);
+        auto& tasks = workers[target]->tasks;
+        auto position = tasks.begin();
+        while (position != tasks.end() and position->weight >= weight) {
+            position++;
+        }
+        tasks.insert(position, Task{weight, move(task), &delegatedCpuNanoseconds()});
+        workers[target]->pendingWeight += weight;
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(stateLock);
+    allDone.wait(guard, [this] { return unfinished == 0; });
+}
+
+bool ThreadPool::takeOwn(size_t self, Task& task) {
+    auto& worker = *workers[self];
+    lock_guard<mutex> guard(worker.lock);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = move(worker.tasks.front());
+    worker.tasks.pop_front();
+    worker.pendingWeight -= task.weight;
+    return true;
+}
+
+bool ThreadPool::steal(size_t self, Task& task) {
+    // Steal from the most loaded worker, the victim might get emptied in the meantime so retry a few times
+    for (size_t attempt = 0; attempt < workers.size(); attempt++) {
+        size_t victim = self;
+        double highestWeight = 0;
+        for (size_t i = 0; i < workers.size(); i++) {
+            if (i == self) {
+                continue;
+            }
+            lock_guard<mutex> guard(workers[i]->lock);
+            if (!workers[i]->tasks.empty() and workers[i]->pendingWeight >= highestWeight) {
+                highestWeight = workers[i]->pendingWeight;
+                victim = i;
+            }
+        }
+        if (victim == self) {
+            return false;
+        }
+        lock_guard<mutex> guard(workers[victim]->lock);
+        if (!workers[victim]->tasks.empty()) {
+            task = move(workers[victim]->tasks.back());
+            workers[victim]->tasks.pop_back();
+            workers[victim]->pendingWeight -= task.weight;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    while (true) {
+        Task task;
+        if (takeOwn(self, task) or steal(self, task)) {
+            {
+                lock_guard<mutex> guard(stateLock);
+                queued--;
+            }
+            long long cpuStart = taskCpuNanoseconds();
+            task.work();
+            *task.cpu += taskCpuNanoseconds() - cpuStart;
+            lock_guard<mutex> guard(stateLock);
+            if (--unfinished == 0) {
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        unique_lock<mutex> guard(stateLock);
+        workAvailable.wait(guard, [this] { return stopping or queued > 0; });
+        if (stopping and queued == 0) {
+            return;
+        }
+    }
+}
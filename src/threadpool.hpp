@@ -0,0 +1,86 @@
+/**
+ * Work-stealing thread pool used to run independent solver tasks in parallel
+ * Every worker owns a deque of tasks ordered from the heaviest to the lightest one. A worker takes the heaviest
+ * task of its own deque and when it runs out of work, it steals the lightest task of the most loaded worker,
+ * so the large instances are started first and the small ones fill the gaps at the end.
+ * The CPU time of every task is added to the submitting thread (see delegatedCpuNanoseconds()), so the phases
+ * run on the pool are timed in full.
+**/
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class ThreadPool {
+public:
+    /**
+     * Starts the given number of worker threads.
+     * @param threads number of workers, 0 means one worker per hardware thread
+     */
+    explicit ThreadPool(size_t threads = 0);
+
+    /**
+     * Waits for all submitted tasks to finish and joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Submits the task to the worker with the least pending work.
+     * @param task the work to be done, it must not throw
+     * @param weight estimated cost of the task (e.g. based on the size of the instance)
+     */
+    void submit(function<void()> task, double weight = 1.0);
+
+    /**
+     * Blocks until all submitted tasks have finished.
+     */
+    void wait();
+
+    /**
+     * Retrieves the number of workers.
+     * @return number of worker threads
+     */
+    size_t size() const;
+
+private:
+    struct Task {
+        double weight;
+        function<void()> work;
+        atomic<long long>* cpu = nullptr; // CPU time counter of the submitting thread
+    };
+
+    struct Worker {
+        mutex lock;
+        deque<Task> tasks;      // sorted by weight, the heaviest first
+        double pendingWeight = 0;
+    };
+
+    vector<unique_ptr<Worker>> workers;
+    vector<thread> threads;
+
+    mutex stateLock;
+    condition_variable workAvailable;
+    condition_variable allDone;
+    size_t queued = 0;          // tasks waiting in deques
+    size_t unfinished = 0;      // tasks submitted but not yet finished
+    bool stopping = false;
+
+    void workerLoop(size_t self);
+    bool takeOwn(size_t self, Task& task);
+    bool steal(size_t self, Task& task);
+};
+
+#endif //THREADPOOL_HPP
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cmath>
+#include "timewindows.hpp"
+
+TimeWindowSegment TimeWindowSegment::depot(double horizon) {
+    TimeWindowSegment segment;
+    segment.latest = horizon;
+    return segment;
+}
+
+TimeWindowSegment TimeWindowSegment::customer(int customerId, const vector<Request>& requests) {
+    auto& request = requests[customerId-2]; // customer with ID 2 has the request n. 0
+    TimeWindowSegment segment;
+    segment.duration = request.service;
+    segment.earliest = request.ready;
+    segment.latest = request.due;
+    segment.first = customerId - 1;
+    segment.last = customerId - 1;
+    return segment;
+}
+
+TimeWindowSegment TimeWindowSegment::merge(const TimeWindowSegment& next, const DistanceMatrix& distanceMatrix) const {
+    double travel = distanceMatrix[last][next.first];
+    double delta = duration - timeWarp + travel; // time from the start of this segment to the start of the next one
+    double waiting = max(next.earliest - delta - latest, 0.0);
+    double warp = max(earliest + delta - next.latest, 0.0);
+
+    TimeWindowSegment merged;
+    merged.duration = duration + next.duration + travel + waiting;
+    merged.timeWarp = timeWarp + next.timeWarp + warp;
+    merged.earliest = max(next.earliest - delta, earliest) - waiting;
+    merged.latest = min(next.latest - delta, latest) + warp;
+    merged.first = first;
+    merged.last = next.last;
+    return merged;
+}
+
+bool hasTimeWindows(const vector<Request>& requests) {
+    return any_of(requests.begin(), requests.end(), [](const Request& request) {
+        return request.ready > 0 or !isinf(request.due) or request.service > 0;
+    });
+}
+
+double routeTimeWarp(const vector<int>& route, const vector<Request>& requests, double horizon,
+                     const DistanceMatrix& distanceMatrix) {
+    auto depot = TimeWindowSegment::depot(horizon);
+    auto segment = depot;
+    for (auto& customer : route) {
+        segment = segment.merge(TimeWindowSegment::customer(customer, requests), distanceMatrix);
+    }
+    return segment.merge(depot, distanceMatrix).timeWarp;
+}
+
+RouteTimeWindows::RouteTimeWindows(const vector<int>& route, const vector<Request>& requests, double horizon,
+                                   const DistanceMatrix& distanceMatrix) {
+    this->requests = &requests;
+    this->distanceMatrix = &distanceMatrix;
+    size_t n = route.size();
+    auto depot = TimeWindowSegment::depot(horizon);
+    forward.assign(n + 1, depot);
+    backward.assign(n + 1, depot);
+    for (size_t i = 0; i < n; i++) {
+        forward[i+1] = forward[i].merge(TimeWindowSegment::customer(route[i], requests), distanceMatrix);
+    }
+    for (size_t i = n; i-- > 0;) {
+        backward[i] = TimeWindowSegment::customer(route[i], requests).merge(backward[i+1], distanceMatrix);
+    }
+}
+
+double RouteTimeWindows::timeWarp() const {
+    return forward.back().merge(backward.back(), *distanceMatrix).timeWarp;
+}
+
+double RouteTimeWindows::insertionTimeWarp(size_t position, int customerId) const {
+    return forward[position].merge(TimeWindowSegment::customer(customerId, *requests), *distanceMatrix)
+                            .merge(backward[position], *distanceMatrix).timeWarp;
+}
+
+double RouteTimeWindows::removalTimeWarp(size_t position) const {
+    return forward[position].merge(backward[position+1], *distanceMatrix).timeWarp;
+}
+
+double RouteTimeWindows::replacementTimeWarp(size_t position, int customerId) const {
+    return forward[position].merge(TimeWindowSegment::customer(customerId, *requests), *distanceMatrix)
+                            .merge(backward[position+1], *distanceMatrix).timeWarp;
+}
+
+double RouteTimeWindows::exchangeTimeWarp(size_t length, const RouteTimeWindows& other, size_t from) const {
+    return forward[length].merge(other.backward[from], *distanceMatrix).timeWarp;
+}
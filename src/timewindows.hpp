@@ -0,0 +1,144 @@
+/**
+ * Time windows of the customers (VRPTW)
+ * A route is described by a segment summarizing its timing (Vidal et al., A hybrid genetic algorithm with adaptive
+ * diversity management for a large class of vehicle routing problems with time-windows, 2013). Segments can be
+ * concatenated in O(1), so with the segments of the prefixes and suffixes of a route, the time warp of a modified
+ * route is known in O(1) without simulating it again. The time warp is the time the vehicle would need to travel
+ * back to meet the windows, it is 0 for a feasible route and penalized otherwise.
+ * The travel times are the distances of the distance matrix.
+**/
+
+#ifndef TIMEWINDOWS_HPP
+#define TIMEWINDOWS_HPP
+
+#include <limits>
+#include <vector>
+#include "../structures/Request.hpp"
+#include "distancematrix.hpp"
+
+using namespace std;
+
+// Penalty of one unit of the time warp in the fitness of the algorithms
+const double TIME_WARP_PENALTY = 10;
+
+class TimeWindowSegment {
+public:
+    double duration = 0;    // travel, service and waiting time of the segment
+    double timeWarp = 0;    // time warp inside the segment
+    double earliest = 0;    // the earliest start of the segment without waiting
+    double latest = numeric_limits<double>::infinity(); // the latest start of the segment without more time warp
+    int first = 0;          // matrix index of the first node
+    int last = 0;           // matrix index of the last node
+
+    /**
+     * Constructs the segment of the depot, the vehicles leave at 0 and have to be back until the horizon.
+     * @param horizon the latest return to the depot
+     * @return the segment
+     */
+    static TimeWindowSegment depot(double horizon);
+
+    /**
+     * Constructs the segment of a single customer.
+     * @param customerId ID of the customer
+     * @param requests requests of the customers, customer with ID i has the request i-2
+     * @return the segment
+     */
+    static TimeWindowSegment customer(int customerId, const vector<Request>& requests);
+
+    /**
+     * Concatenates the segment with the following one.
+     * Time complexity: O(1)
+     * @param next the segment visited after this one
+     * @param distanceMatrix travel times between the nodes
+     * @return the segment of both
+     */
+    TimeWindowSegment merge(const TimeWindowSegment& next, const DistanceMatrix& distanceMatrix) const;
+};
+
+/**
+ * Checks whether any request has a time window or a service time.
+ * @param requests requests of the customers
+ * @return true if the time windows have to be taken into account
+ */
+bool hasTimeWindows(const vector<Request>& requests);
+
+/**
+ * Calculates the time warp of the route starting and ending in the depot.
+ * Time complexity: O(n)
+ * @param route customer IDs of the route
+ * @param requests requests of the customers, customer with ID i has the request i-2
+ * @param horizon the latest return to the depot
+ * @param distanceMatrix travel times between the nodes
+ * @return the time warp, 0 if the route meets all time windows
+ */
+double routeTimeWarp(const vector<int>& route, const vector<Request>& requests, double horizon,
+                     const DistanceMatrix& distanceMatrix);
+
+/**
+ * Segments of all prefixes and suffixes of a route (depot included), for O(1) evaluation of moves.
+ */
+class RouteTimeWindows {
+private:
+    vector<TimeWindowSegment> forward;  // forward[i] covers the depot and the first i customers
+    vector<TimeWindowSegment> backward; // backward[i] covers the customers from the position i and the depot
+    const vector<Request>* requests;
+    const DistanceMatrix* distanceMatrix;
+
+public:
+    /**
+     * Builds the segments of the route.
+     * Time complexity: O(n)
+     * @param route customer IDs of the route
+     * @param requests requests of the customers, customer with ID i has the request i-2
+     * @param horizon the latest return to the depot
+     * @param distanceMatrix travel times between the nodes
+     */
+    RouteTimeWindows(const vector<int>& route, const vector<Request>& requests, double horizon,
+                     const DistanceMatrix& distanceMatrix);
+
+    /**
+     * Retrieves the time warp of the whole route.
+     * @return the time warp
+     */
+    double timeWarp() const;
+
+    /**
+     * Calculates the time warp of the route with the customer inserted before the given position.
+     * Time complexity: O(1)
+     * @param position position in the route (0 inserts before the first customer)
+     * @param customerId ID of the inserted customer
+     * @return the time warp of the modified route
+     */
+    double insertionTimeWarp(size_t position, int customerId) const;
+
+    /**
+     * Calculates the time warp of the route with the customer at the given position removed.
+     * Time complexity: O(1)
+     * @param position position of the removed customer
+     * @return the time warp of the modified route
+     */
+    double removalTimeWarp(size_t position) const;
+
+    /**
+     * Calculates the time warp of the route with the customer at the given position replaced by another one
+     * (one half of the swap move between two routes).
+     * Time complexity: O(1)
+     * @param position position of the replaced customer
+     * @param customerId ID of the customer taking its place
+     * @return the time warp of the modified route
+     */
+    double replacementTimeWarp(size_t position, int customerId) const;
+
+    /**
+     * Calculates the time warp of the route made of the prefix of this route and the suffix of another one
+     * (the 2-opt* move between two routes).
+     * Time complexity: O(1)
+     * @param length number of customers of this route that are kept
+     * @param other the route providing the end
+     * @param from position in the other route where its part starts
+     * @return the time warp of the new route
+     */
+    double exchangeTimeWarp(size_t length, const RouteTimeWindows& other, size_t from) const;
+};
+
+#endif //TIMEWINDOWS_HPP
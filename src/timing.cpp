@@ -0,0 +1,33 @@
+#include <ctime>
+#include "timing.hpp"
+
+long long threadCpuNanoseconds() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+atomic<long long>& delegatedCpuNanoseconds() {
+    static thread_local atomic<long long> delegated(0);
+    return delegated;
+}
+
+long long taskCpuNanoseconds() {
+    return threadCpuNanoseconds() + delegatedCpuNanoseconds().load();
+}
+
+static long long taskCpuMicroseconds() {
+    return taskCpuNanoseconds() / 1000;
+}
+
+PhaseTimer::PhaseTimer() {
+    wallStart = chrono::steady_clock::now();
+    cpuStart = taskCpuMicroseconds();
+}
+
+PhaseTime PhaseTimer::elapsed() const {
+    PhaseTime time;
+    time.wall = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - wallStart).count();
+    time.cpu = taskCpuMicroseconds() - cpuStart;
+    return time;
+}
@@ -0,0 +1,55 @@
+/**
+ * Measurement of the wall-clock and CPU time spent in the phases of the solver
+**/
+
+#ifndef TIMING_HPP
+#define TIMING_HPP
+
+#include <atomic>
+#include <chrono>
+#include "../structures/Solution.hpp"
+
+using namespace std;
+
+class PhaseTimer {
+private:
+    chrono::steady_clock::time_point wallStart;
+    long long cpuStart;
+
+public:
+    /**
+     * Starts measuring the phase.
+     */
+    PhaseTimer();
+
+    /**
+     * Retrieves the time elapsed since the start of the measurement.
+     * The CPU time is the time consumed by the calling thread and by the thread pool tasks it submitted (see
+     * taskCpuNanoseconds()), so a phase run on a pool is measured in full, while the other instances solved in
+     * parallel (batch mode) are not counted.
+     * @return wall-clock and CPU time in microseconds
+     */
+    PhaseTime elapsed() const;
+};
+
+/**
+ * Retrieves the CPU time consumed by the calling thread, fine enough to measure a single operation.
+ * @return the CPU time in nanoseconds
+ */
+long long threadCpuNanoseconds();
+
+/**
+ * Retrieves the counter of the CPU time of the thread pool tasks submitted by the calling thread, the workers
+ * add the time of every task to the counter of its submitter. The counter lives as long as the thread, which
+ * has to wait for its tasks.
+ * @return the counter in nanoseconds
+ */
+atomic<long long>& delegatedCpuNanoseconds();
+
+/**
+ * Retrieves the CPU time consumed by the calling thread together with its thread pool tasks (and their tasks).
+ * @return the CPU time in nanoseconds
+ */
+long long taskCpuNanoseconds();
+
+#endif //TIMING_HPP
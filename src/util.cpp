@@ -35,27 +35,12 @@ double distance(Node first, Node second) {
  * Function to create a distance matrix containing distances between nodes
  * For the distance matrix we assume that the IDs of the customers are ordered from 1 to n
  * The reason for the matrix is that it's better to calculate the distances only once and not repeat it every time
- * TODO: could be optimized since it is symmetrical
  **/
-vector<vector<double>> calculateDistanceMatrix(vector<Node> customers) {
-
-    size_t n_of_customers = customers.size();
-
-    vector<vector<double>> distanceMatrix(n_of_customers, vector<double> (n_of_customers, 0));
-
-    for (auto& customer : customers) {
-        int matrix_pos_x = customer.id - 1; // Node IDs start with 1 (the depot), need to lower this to start indexing from 0
-
-        // For each customer, go through the customer list and calculate distances
-        for (auto next_customer : customers) {
-            int matrix_pos_y = next_customer.id - 1;
-            distanceMatrix[matrix_pos_x][matrix_pos_y] = distance(customer, next_customer);
-        }
-    }
-    return distanceMatrix;
+DistanceMatrix calculateDistanceMatrix(const vector<Node>& customers) {
+    return DistanceMatrix::euclidean(customers);
 }
 
-void printDistanceMatrix(vector<vector<double>> &distanceMatrix) {
+void printDistanceMatrix(const DistanceMatrix &distanceMatrix) {
     // print header
     cout << setw(10) << " ";
     cout << setw(10) << "D0";
@@ -73,9 +58,35 @@ void printDistanceMatrix(vector<vector<double>> &distanceMatrix) {
             cout << setw(10) << "C" << i;
         }
         // Print distances
-        for (auto& distance : distanceMatrix[i]) {
-            cout << setw(10) << distance;
+        for (int j = 0; j < (int)distanceMatrix.size(); j++) {
+            cout << setw(10) << distanceMatrix[i][j];
         }
         cout << endl;
     }
 }
+
+/**
+ * Function to calculate the 64-bit FNV-1a hash of the given bytes
+ * The hash can be chained by passing the result of the previous call as the initial value
+ **/
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Function to calculate the hash identifying the distance matrix of the nodes (their IDs and coordinates)
+ **/
+uint64_t hashCoordinates(const vector<Node>& nodes) {
+    uint64_t hash = hashBytes(nullptr, 0);
+    for (auto& node : nodes) {
+        hash = hashBytes(&node.id, sizeof(node.id), hash);
+        hash = hashBytes(&node.x, sizeof(node.x), hash);
+        hash = hashBytes(&node.y, sizeof(node.y), hash);
+    }
+    return hash;
+}
@@ -5,7 +5,9 @@
 #ifndef UTIL_HPP
 #define UTIL_HPP
 
+#include <cstdint>
 #include "../structures/DataReader.hpp"
+#include "distancematrix.hpp"
 
 using namespace std;
 
@@ -13,8 +15,11 @@ void print1D(vector<int> vec);
 void print2D(vector<vector<int>> vec);
 
 double distance(Node first, Node second);
-vector<vector<double>> calculateDistanceMatrix(vector<Node> customers);
+DistanceMatrix calculateDistanceMatrix(const vector<Node>& customers);
 
-void printDistanceMatrix(vector<vector<double>>& distanceMatrix);
+void printDistanceMatrix(const DistanceMatrix& distanceMatrix);
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ULL);
+uint64_t hashCoordinates(const vector<Node>& nodes);
 
 #endif //UTIL_HPP
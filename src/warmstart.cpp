@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include "warmstart.hpp"
+#include "timewindows.hpp"
+
+// Reads all integers of the text separated by spaces
+static vector<int> parseIds(const string& text) {
+    vector<int> ids;
+    istringstream in(text);
+    int id;
+    while (in >> id) {
+        ids.push_back(id);
+    }
+    return ids;
+}
+
+vector<vector<int>> readSolutionRoutes(const string& path) {
+    ifstream file(path);
+    if (!file) {
+        throw runtime_error("Cannot open the solution " + path);
+    }
+    stringstream buffer;
+    buffer << file.rdbuf();
+    string content = buffer.str();
+
+    vector<vector<int>> routes;
+    size_t json = content.find("\"routes\"");
+    if (json != string::npos) {
+        // JSON, the routes are an array of arrays of IDs
+        int depth = 0;
+        vector<int> route;
+        string number;
+        for (size_t i = content.find('[', json); i < content.size(); i++) {
+            char c = content[i];
+            if (isdigit((unsigned char)c)) {
+                number += c;
+                continue;
+            }
+            if (!number.empty()) {
+                route.push_back(stoi(number));
+                number.clear();
+            }
+            if (c == '[') {
+                depth++;
+            } else if (c == ']') {
+                if (depth == 2) {
+                    routes.push_back(route);
+                    route.clear();
+                }
+                if (--depth == 0) {
+                    break;
+                }
+            }
+        }
+    } else {
+        // text, one "#<number> <IDs>" line per route, or CSV with the routes in the last column separated by '|'
+        istringstream lines(content);
+        string line;
+        string lastRow;
+        while (getline(lines, line)) {
+            if (!line.empty() and line[0] == '#') {
+                size_t space = line.find(' ');
+                routes.push_back(space != string::npos ? parseIds(line.substr(space)) : vector<int>());
+            } else if (line.find(',') != string::npos and line.rfind("instance,", 0) != 0) {
+                lastRow = line;
+            }
+        }
+        if (routes.empty() and !lastRow.empty()) {
+            stringstream column(lastRow.substr(lastRow.rfind(',') + 1));
+            string route;
+            while (getline(column, route, '|')) {
+                routes.push_back(parseIds(route));
+            }
+        }
+    }
+    routes.erase(remove_if(routes.begin(), routes.end(), [](const vector<int>& route) { return route.empty(); }),
+                 routes.end());
+    if (routes.empty()) {
+        throw runtime_error("No routes found in the solution " + path);
+    }
+    return routes;
+}
+
+vector<vector<int>> repairRoutes(const vector<vector<int>>& routes, const vector<Request>& requests, const Fleet& fleet,
+                                 const DistanceMatrix& distanceMatrix) {
+    int lastCustomer = requests.size() + 1;
+    double capacity = fleet.maxCapacity();
+    vector<bool> served(lastCustomer + 1, false);
+    vector<vector<int>> repaired;
+    vector<double> loads;
+    for (auto& route : routes) {
+        vector<int> kept;
+        double load = 0;
+        for (int customer : route) {
+            if (customer >= 2 and customer <= lastCustomer and !served[customer]) {
+                served[customer] = true;
+                kept.push_back(customer);
+                load += requests[customer-2].quantity;
+            }
+        }
+        // the demands may have grown since, the customers at the end of the route are inserted again
+        while (load > capacity) {
+            served[kept.back()] = false;
+            load -= requests[kept.back()-2].quantity;
+            kept.pop_back();
+        }
+        if (!kept.empty()) {
+            repaired.push_back(kept);
+            loads.push_back(load);
+        }
+    }
+
+    vector<int> missing;
+    for (int customer = 2; customer <= lastCustomer; customer++) {
+        if (!served[customer]) {
+            missing.push_back(customer);
+        }
+    }
+    stable_sort(missing.begin(), missing.end(), [&](int a, int b) {
+        return requests[a-2].quantity > requests[b-2].quantity;
+    });
+    for (int customer : missing) {
+        double quantity = requests[customer-2].quantity;
+        double bestCost = numeric_limits<double>::infinity();
+        size_t bestRoute = repaired.size();
+        size_t bestPosition = 0;
+        for (size_t r = 0; r < repaired.size(); r++) {
+            if (loads[r] + quantity > capacity) {
+                continue;
+            }
+            auto& route = repaired[r];
+            double timeWarp = 0;
+            optional<RouteTimeWindows> timing;
+            if (fleet.timeWindows) {
+                timing.emplace(route, requests, fleet.horizon, distanceMatrix);
+                timeWarp = timing->timeWarp();
+            }
+            for (size_t position = 0; position <= route.size(); position++) {
+                int previous = position == 0 ? 0 : route[position-1] - 1;
+                int next = position == route.size() ? 0 : route[position] - 1;
+                double cost = distanceMatrix[previous][customer-1] + distanceMatrix[customer-1][next]
+                              - distanceMatrix[previous][next];
+                if (timing) {
+                    cost += (timing->insertionTimeWarp(position, customer) - timeWarp) * TIME_WARP_PENALTY;
+                }
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestRoute = r;
+                    bestPosition = position;
+                }
+            }
+        }
+        if (bestRoute == repaired.size()) {
+            repaired.push_back(vector<int>());
+            loads.push_back(0);
+        }
+        repaired[bestRoute].insert(repaired[bestRoute].begin() + bestPosition, customer);
+        loads[bestRoute] += quantity;
+    }
+    return repaired;
+}
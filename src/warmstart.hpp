@@ -0,0 +1,46 @@
+/**
+ * Warm start of the search from a previous solution
+ * A re-planned instance usually differs from the previous plan by a few customers, so the previous routes are a far
+ * better starting point than a random population or a fresh savings solution. The routes are read from the output
+ * of gal (text, JSON or CSV), the customers that are no longer in the instance are dropped, overloaded routes are
+ * shortened and the new customers are inserted where they cost the least.
+**/
+
+#ifndef WARMSTART_HPP
+#define WARMSTART_HPP
+
+#include <string>
+#include <vector>
+#include "../structures/Request.hpp"
+#include "distancematrix.hpp"
+#include "fleet.hpp"
+
+using namespace std;
+
+/**
+ * Reads the routes of a solution printed by gal in any of its output formats.
+ * Time complexity: O(s) for the size s of the file
+ * Space complexity: O(n)
+ * @param path path to the file
+ * @return customer IDs of the routes (without the depot)
+ * @throws runtime_error if the file cannot be read or contains no routes
+ */
+vector<vector<int>> readSolutionRoutes(const string& path);
+
+/**
+ * Adapts the routes of a previous solution to the instance. Unknown and repeated customers are dropped, the last
+ * customers of a route over the capacity of the largest vehicle are taken out and all customers missing from
+ * the routes are inserted one by one (the largest demand first) at the cheapest position with enough capacity,
+ * the time warp penalized with time windows. A customer that fits nowhere gets a new route.
+ * Time complexity: O(m * n) for m inserted customers
+ * Space complexity: O(n)
+ * @param routes customer IDs of the routes of the previous solution
+ * @param requests requests of the customers, customer with ID i has the request i-2
+ * @param fleet the available vehicles
+ * @param distanceMatrix distances between all nodes
+ * @return routes serving every customer of the instance exactly once
+ */
+vector<vector<int>> repairRoutes(const vector<vector<int>>& routes, const vector<Request>& requests, const Fleet& fleet,
+                                 const DistanceMatrix& distanceMatrix);
+
+#endif //WARMSTART_HPP
@@ -1,6 +1,6 @@
 #include <iostream>
-#include <iostream>
 #include <fstream>
+#include <stdexcept>
 
 #include "DataReader.hpp"
 #include "../libs/pugixml.hpp"
@@ -13,10 +13,27 @@ VRPDataReader::VRPDataReader(string filename) {
     pugi::xml_parse_result result = doc.load_file(filename.c_str());
 
     if (!result) {
-        cerr << "Something went wrong when loading the file!";
-        exit(1);
+        throw runtime_error("Something went wrong when loading the file " + filename + "!");
     }
+    read(doc);
+}
+
+VRPDataReader::VRPDataReader() {
+}
+
+VRPDataReader VRPDataReader::fromString(const string& xml) {
+    pugi::xml_document doc;
+    pugi::xml_parse_result result = doc.load_buffer(xml.data(), xml.size());
 
+    if (!result) {
+        throw runtime_error(string("Something went wrong when parsing the instance: ") + result.description());
+    }
+    VRPDataReader reader;
+    reader.read(doc);
+    return reader;
+}
+
+void VRPDataReader::read(const pugi::xml_document& doc) {
     vector<Node> nodes;
     vector<Vehicle> vehicles;
     vector<Request> requests;
@@ -36,6 +53,9 @@ VRPDataReader::VRPDataReader(string filename) {
     for (pugi::xml_node node : doc.child("instance").child("fleet").children("vehicle_profile")) {
         auto type = node.attribute("type").as_int();
         auto capacity = stod(node.child("capacity").child_value());
+        auto number = node.attribute("number").as_int(-1);
+        auto maxTravelTime = node.child("max_travel_time") ? stod(node.child("max_travel_time").child_value())
+                                                            : numeric_limits<double>::infinity();
 
         auto dep_node_id = stoi(node.child("departure_node").child_value());
         auto arr_node_id = stoi(node.child("arrival_node").child_value());
@@ -52,7 +72,7 @@ VRPDataReader::VRPDataReader(string filename) {
             }
         }
 
-        Vehicle my_vehicle = Vehicle(type, departure, arrival, capacity);
+        Vehicle my_vehicle = Vehicle(type, departure, arrival, capacity, number, maxTravelTime);
         vehicles.push_back(my_vehicle);
     }
 
@@ -61,6 +81,14 @@ VRPDataReader::VRPDataReader(string filename) {
         auto id = node.attribute("id").as_int();
         auto whereto_id = node.attribute("node").as_int();
         auto quantity = stod(node.child("quantity").child_value());
+        // time window and service time are optional (VRPTW instances)
+        double ready = 0;
+        double due = numeric_limits<double>::infinity();
+        if (node.child("tw")) {
+            ready = stod(node.child("tw").child("start").child_value());
+            due = stod(node.child("tw").child("end").child_value());
+        }
+        auto service = node.child("service_time") ? stod(node.child("service_time").child_value()) : 0.0;
 
         Node whereto;
         
@@ -70,7 +98,7 @@ VRPDataReader::VRPDataReader(string filename) {
             }
         }
 
-        Request req = Request(id, whereto, quantity);
+        Request req = Request(id, whereto, quantity, ready, due, service);
         requests.push_back(req);
     }
 
@@ -9,12 +9,21 @@
 
 using namespace std;
 
+namespace pugi {
+    class xml_document;
+}
+
 class VRPDataReader {
     public:
         VRPDataReader(string filename);
+        static VRPDataReader fromString(const string& xml); // loads the instance from the XML kept in memory
         vector<Node> nodes;
         vector<Vehicle> vehicles;
         vector<Request> requests;
+
+    private:
+        VRPDataReader();
+        void read(const pugi::xml_document& doc);
 };
 
 #endif
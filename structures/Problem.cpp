@@ -0,0 +1,92 @@
+#include <stdexcept>
+#include "Problem.hpp"
+#include "DataReader.hpp"
+
+Problem::Problem() {
+}
+
+Problem::Problem(vector<Node> nodes, vector<Request> requests, vector<Vehicle> vehicles) {
+    this->nodes = nodes;
+    this->requests = requests;
+    this->vehicles = vehicles;
+}
+
+Problem Problem::load(const string& filename) {
+    VRPDataReader reader = VRPDataReader(filename);
+    Problem problem(reader.nodes, reader.requests, reader.vehicles);
+    problem.name = filename;
+    return problem;
+}
+
+Problem Problem::parse(const string& xml) {
+    VRPDataReader reader = VRPDataReader::fromString(xml);
+    return Problem(reader.nodes, reader.requests, reader.vehicles);
+}
+
+void Problem::addDepot(double x, double y) {
+    if (!requests.empty()) {
+        throw logic_error("The depots have to be added before the customers");
+    }
+    nodes.push_back(Node(nodes.size() + 1, 0, x, y));
+}
+
+int Problem::addCustomer(double x, double y, double quantity, double ready, double due, double service) {
+    if (nodes.empty()) {
+        throw logic_error("The depot has to be added before the customers");
+    }
+    int id = nodes.size() + 1;
+    Node customer(id, 1, x, y);
+    nodes.push_back(customer);
+    requests.push_back(Request(requests.size() + 1, customer, quantity, ready, due, service));
+    return id;
+}
+
+void Problem::addVehicle(double capacity) {
+    if (nodes.empty()) {
+        throw logic_error("The depot has to be added before the vehicles");
+    }
+    vehicles.push_back(Vehicle(0, nodes[0], nodes[0], capacity));
+}
+
+double Problem::vehicleCapacity() const {
+    return vehicles[0].capacity;
+}
+
+int Problem::depotCount() const {
+    int depots = 1; // the first node is always the depot
+    while (depots < (int)nodes.size() and nodes[depots].type == 0) {
+        depots++;
+    }
+    return depots;
+}
+
+void Problem::validate() const {
+    if (nodes.size() < 2) {
+        throw invalid_argument("The problem needs a depot and at least one customer");
+    }
+    if (vehicles.empty()) {
+        throw invalid_argument("The problem needs at least one vehicle");
+    }
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].id != (int)i + 1) {
+            throw invalid_argument("Node IDs have to be ordered from 1 (the depot) to n");
+        }
+    }
+    size_t depots = depotCount();
+    for (size_t i = depots; i < nodes.size(); i++) {
+        if (nodes[i].type == 0) {
+            throw invalid_argument("The depots have to be the first nodes of the problem");
+        }
+    }
+    if (requests.size() != nodes.size() - depots) {
+        throw invalid_argument("Every customer has to have exactly one request");
+    }
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (requests[i].whereto.id != (int)(i + depots) + 1) {
+            throw invalid_argument("Requests have to be ordered by the customer node IDs");
+        }
+        if (requests[i].ready > requests[i].due) {
+            throw invalid_argument("The time window of customer " + to_string(requests[i].whereto.id) + " ends before it starts");
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef PROBLEM_H
+#define PROBLEM_H
+
+#include <string>
+#include <vector>
+#include "Node.hpp"
+#include "Vehicle.hpp"
+#include "Request.hpp"
+
+using namespace std;
+
+// Class representing one instance of the CVRP that can be either loaded from a file or built in memory
+// The algorithms expect the node with ID 1 to be the depot, customers to have IDs 2..n and the request
+// of the customer with ID i to be stored at the index i-2
+// A problem with several depots (nodes of type 0) has them first, with IDs 1..m, and the customers after them,
+// the solver splits it into single-depot problems that follow the convention above
+class Problem {
+    public:
+        Problem();
+        Problem(vector<Node> nodes, vector<Request> requests, vector<Vehicle> vehicles);
+        string name; // Name of the instance (path to the file it was loaded from)
+        vector<Node> nodes; // The 0th node is the depot (the first m nodes if there are m depots)
+        vector<Request> requests; // Each customer has single request
+        vector<Vehicle> vehicles; // Vehicle profiles
+
+        /**
+         * Loads the problem from the XML file in the VRP-REP format.
+         * @param filename path to the file
+         * @return the loaded problem
+         * @throws runtime_error if the file cannot be loaded
+         */
+        static Problem load(const string& filename);
+
+        /**
+         * Parses the problem from the XML in the VRP-REP format kept in memory.
+         * @param xml content of the instance file
+         * @return the parsed problem
+         * @throws runtime_error if the XML cannot be parsed
+         */
+        static Problem parse(const string& xml);
+
+        /**
+         * Adds a depot to the problem. The depots have to be added before any customer.
+         * @param x X coordinate of the depot
+         * @param y Y coordinate of the depot
+         */
+        void addDepot(double x, double y);
+
+        /**
+         * Adds the customer with its request to the problem. The customer gets the next free node ID.
+         * @param x X coordinate of the customer
+         * @param y Y coordinate of the customer
+         * @param quantity quantity of goods requested by the customer
+         * @param ready the earliest time the service can start
+         * @param due the latest time the service can start
+         * @param service duration of the service
+         * @return node ID of the customer
+         */
+        int addCustomer(double x, double y, double quantity, double ready = 0,
+                        double due = numeric_limits<double>::infinity(), double service = 0);
+
+        /**
+         * Adds the vehicle departing from and arriving to the depot.
+         * @param capacity how much the vehicle can carry
+         */
+        void addVehicle(double capacity);
+
+        /**
+         * Retrieves the capacity used by the algorithms (the capacity of the first vehicle).
+         * @return capacity of the vehicles
+         */
+        double vehicleCapacity() const;
+
+        /**
+         * Retrieves the number of depots (the nodes of type 0 at the start of the nodes).
+         * @return number of depots
+         */
+        int depotCount() const;
+
+        /**
+         * Checks that the problem follows the conventions expected by the algorithms (see the class comment).
+         * @throws invalid_argument describing the first violation found
+         */
+        void validate() const;
+};
+
+#endif
@@ -1,7 +1,10 @@
 #include "Request.hpp"
 
-Request::Request(int id, Node whereto, double quantity) {
+Request::Request(int id, Node whereto, double quantity, double ready, double due, double service) {
     this->id = id;
     this->whereto = whereto;
     this->quantity = quantity;
+    this->ready = ready;
+    this->due = due;
+    this->service = service;
 }
@@ -1,6 +1,7 @@
 #ifndef REQ_H
 #define REQ_H
 
+#include <limits>
 #include "Node.hpp"
 
 using namespace std;
@@ -8,10 +9,14 @@ using namespace std;
 // Class representing each request
 class Request {
     public:
-        Request(int id, Node whereto, double quantity);
+        Request(int id, Node whereto, double quantity, double ready = 0,
+                double due = numeric_limits<double>::infinity(), double service = 0);
         int id; // request id
         Node whereto; // Node of the request creator
         double quantity; // how much he requires
+        double ready; // the earliest time the service can start (start of the time window)
+        double due; // the latest time the service can start (end of the time window)
+        double service; // how long the service takes
 };
 
 #endif
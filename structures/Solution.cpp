@@ -0,0 +1,183 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include "Solution.hpp"
+
+Solution::Solution() {
+    this->distance = 0.0;
+    this->vehicles = 0;
+    this->averageCustomers = 0.0;
+    this->routesWithOneCustomer = 0;
+    this->routesWithTwoCustomers = 0;
+    this->unusedCapacity = 0.0;
+    this->timeWindows = false;
+    this->timeWarp = 0.0;
+    this->algorithmTime = 0;
+}
+
+void Solution::calculateStatistics(const vector<Request>& requests, double vehicleCapacity) {
+    vehicles = routes.size();
+    routesWithOneCustomer = 0;
+    routesWithTwoCustomers = 0;
+    unusedCapacity = 0.0;
+
+    size_t customers = 0;
+    for (size_t i = 0; i < routes.size(); i++) {
+        auto& route = routes[i];
+        if (route.size() == 1) {
+            routesWithOneCustomer++;
+        } else if (route.size() == 2) {
+            routesWithTwoCustomers++;
+        }
+        double load = 0.0;
+        for (auto& customerId : route) {
+            load += requests[customerId-2].quantity; // customer with ID 2 has the request n. 0
+        }
+        unusedCapacity += (i < capacities.size() ? capacities[i] : vehicleCapacity) - load;
+        customers += route.size();
+    }
+    averageCustomers = vehicles > 0 ? (double)customers / vehicles : 0.0;
+}
+
+void Solution::printOut(ostream& out) const {
+    auto routeNum = 1;
+    for (auto& route : routes) {
+        out << "#" << routeNum++;
+        for (auto& customerId : route) {
+            out << " " << customerId;
+        }
+        out << endl;
+    }
+    out << "Overall distances: " << distance << endl;
+    out << "Vehicles: " << vehicles << endl;
+    out << "Average number of customers: " << averageCustomers << endl;
+    out << "Number of routes linking only one customer: " << routesWithOneCustomer << endl;
+    out << "Number of routes linking only two customers: " << routesWithTwoCustomers << endl;
+    out << "Unused capacity: " << unusedCapacity << endl;
+    if (timeWindows) {
+        out << "Time warp: " << timeWarp << endl;
+    }
+    if (!depots.empty()) {
+        out << "Depots:";
+        for (auto& depot : depots) {
+            out << " " << depot;
+        }
+        out << endl;
+    }
+    if (!capacities.empty()) {
+        out << "Capacities of the vehicles:";
+        for (auto& capacity : capacities) {
+            out << " " << capacity;
+        }
+        out << endl;
+    }
+    out << "Time of the algorithm " << algorithmTime << " microseconds" << endl;
+}
+
+static string escapeJson(const string& text) {
+    string escaped;
+    for (auto character : text) {
+        if (character == '"' or character == '\\') {
+            escaped += '\\';
+            escaped += character;
+        } else if ((unsigned char)character < 0x20) {
+            ostringstream code;
+            code << "\\u" << hex << setw(4) << setfill('0') << (int)character;
+            escaped += code.str();
+        } else {
+            escaped += character;
+        }
+    }
+    return escaped;
+}
+
+// Quotes the field of a CSV record if it contains a separator, a quote or a line break (RFC 4180)
+static string escapeCsv(const string& text) {
+    if (text.find_first_of(",\"\r\n") == string::npos) {
+        return text;
+    }
+    string escaped = "\"";
+    for (auto character : text) {
+        if (character == '"') {
+            escaped += '"';
+        }
+        escaped += character;
+    }
+    return escaped + "\"";
+}
+
+static void printPhaseJson(ostream& out, const string& name, const PhaseTime& time) {
+    out << "\"" << name << "\":{\"wall_us\":" << time.wall << ",\"cpu_us\":" << time.cpu << "}";
+}
+
+void Solution::printJson(ostream& stream) const {
+    // the line is built first so that rows of solutions printed from multiple threads are not interleaved
+    ostringstream out;
+    out << setprecision(15);
+    out << "{\"instance\":\"" << escapeJson(instance) << "\",\"algorithm\":\"" << escapeJson(algorithm) << "\"";
+    out << ",\"routes\":[";
+    for (size_t i = 0; i < routes.size(); i++) {
+        out << (i ? ",[" : "[");
+        for (size_t j = 0; j < routes[i].size(); j++) {
+            out << (j ? "," : "") << routes[i][j];
+        }
+        out << "]";
+    }
+    out << "]";
+    if (!depots.empty()) {
+        out << ",\"depots\":[";
+        for (size_t i = 0; i < depots.size(); i++) {
+            out << (i ? "," : "") << depots[i];
+        }
+        out << "]";
+    }
+    if (!capacities.empty()) {
+        out << ",\"capacities\":[";
+        for (size_t i = 0; i < capacities.size(); i++) {
+            out << (i ? "," : "") << capacities[i];
+        }
+        out << "]";
+    }
+    out << ",\"distance\":" << distance;
+    out << ",\"vehicles\":" << vehicles;
+    out << ",\"average_customers\":" << averageCustomers;
+    out << ",\"routes_one_customer\":" << routesWithOneCustomer;
+    out << ",\"routes_two_customers\":" << routesWithTwoCustomers;
+    out << ",\"unused_capacity\":" << unusedCapacity;
+    if (timeWindows) {
+        out << ",\"time_warp\":" << timeWarp;
+    }
+    out << ",\"time_us\":" << algorithmTime;
+    out << ",\"timings\":{";
+    printPhaseJson(out, "parse", parseTime); out << ",";
+    printPhaseJson(out, "matrix", matrixTime); out << ",";
+    printPhaseJson(out, "construct", constructTime); out << ",";
+    printPhaseJson(out, "improve", improveTime);
+    out << "}}\n";
+    stream << out.str();
+}
+
+string Solution::csvHeader() {
+    return "instance,algorithm,distance,vehicles,average_customers,routes_one_customer,routes_two_customers,"
+           "unused_capacity,time_us,parse_wall_us,parse_cpu_us,matrix_wall_us,matrix_cpu_us,"
+           "construct_wall_us,construct_cpu_us,improve_wall_us,improve_cpu_us,routes";
+}
+
+void Solution::printCsv(ostream& stream) const {
+    ostringstream out;
+    out << setprecision(15);
+    out << escapeCsv(instance) << "," << escapeCsv(algorithm) << "," << distance << "," << vehicles << "," << averageCustomers << ","
+        << routesWithOneCustomer << "," << routesWithTwoCustomers << "," << unusedCapacity << "," << algorithmTime;
+    for (auto time : {parseTime, matrixTime, constructTime, improveTime}) {
+        out << "," << time.wall << "," << time.cpu;
+    }
+    out << ",";
+    for (size_t i = 0; i < routes.size(); i++) {
+        out << (i ? "|" : "");
+        for (size_t j = 0; j < routes[i].size(); j++) {
+            out << (j ? " " : "") << routes[i][j];
+        }
+    }
+    out << "\n";
+    stream << out.str();
+}
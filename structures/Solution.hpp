@@ -0,0 +1,75 @@
+#ifndef SOLUTION_H
+#define SOLUTION_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Request.hpp"
+
+using namespace std;
+
+// Wall-clock and CPU time spent in one phase of the solver, both in microseconds
+struct PhaseTime {
+    long long wall = 0;
+    long long cpu = 0;
+};
+
+// Class representing the result of one run of an algorithm on one instance
+class Solution {
+    public:
+        Solution();
+        string instance; // Path to the instance the solution belongs to
+        string algorithm; // Name of the algorithm that produced the solution
+        vector<vector<int>> routes; // Customer IDs of each route (the depot is implicit at both ends)
+        vector<double> capacities; // Capacity of the vehicle serving each route (empty if all vehicles are the same)
+        vector<int> depots; // Node ID of the depot of each route (empty if there is a single depot)
+        double distance; // Overall distance of all routes
+        int vehicles; // Number of routes (one vehicle per route)
+        double averageCustomers; // Average number of customers per route
+        int routesWithOneCustomer; // Number of routes linking only one customer
+        int routesWithTwoCustomers; // Number of routes linking only two customers
+        double unusedCapacity; // Capacity left unused summed over all routes
+        bool timeWindows; // Whether the customers have time windows
+        double timeWarp; // Time warp summed over all routes (0 if all time windows are met)
+        long long algorithmTime; // Duration of the algorithm in microseconds
+        PhaseTime parseTime; // Loading of the instance
+        PhaseTime matrixTime; // Calculation of the distance matrix
+        PhaseTime constructTime; // Construction of the initial solution(s)
+        PhaseTime improveTime; // Improvement of the initial solution(s)
+
+        /**
+         * Fills in the route statistics (vehicles, average customers, short routes and unused capacity)
+         * from the routes. Every route is assumed to be served by a vehicle of the given capacity, unless
+         * the capacities of the individual routes are filled in.
+         * @param requests requests of the customers, the customer with ID i has the request i-2
+         * @param vehicleCapacity capacity of the vehicle serving each route without its own capacity
+         */
+        void calculateStatistics(const vector<Request>& requests, double vehicleCapacity);
+
+        /**
+         * Prints the routes and the statistics in the human-readable format
+         * @param out stream to print to
+         */
+        void printOut(ostream& out = cout) const;
+
+        /**
+         * Prints the solution as a single-line JSON object
+         * @param out stream to print to
+         */
+        void printJson(ostream& out = cout) const;
+
+        /**
+         * Prints the solution as a single CSV row, see csvHeader() for the columns.
+         * Routes are separated by '|' and customers within a route by a space, so no quoting is needed.
+         * @param out stream to print to
+         */
+        void printCsv(ostream& out = cout) const;
+
+        /**
+         * Retrieves the header of the CSV output
+         * @return comma separated names of the columns printed by printCsv()
+         */
+        static string csvHeader();
+};
+
+#endif
@@ -1,8 +1,10 @@
 #include "Vehicle.hpp"
 
-Vehicle::Vehicle(int type, Node departure, Node arrival, double capacity) {
+Vehicle::Vehicle(int type, Node departure, Node arrival, double capacity, int number, double maxTravelTime) {
     this->type = type;
     this->departure = departure;
     this->arrival = arrival;
     this->capacity = capacity;
+    this->number = number;
+    this->maxTravelTime = maxTravelTime;
 }
@@ -1,16 +1,22 @@
 #ifndef VEHICLE_H
 #define VEHICLE_H
 
+#include <limits>
 #include "Node.hpp"
 
+using namespace std;
+
 // Class representing each vehicle
 class Vehicle {
     public:
-        Vehicle(int type, Node departure, Node arrival, double capacity);
+        Vehicle(int type, Node departure, Node arrival, double capacity, int number = -1,
+                double maxTravelTime = numeric_limits<double>::infinity());
         int type; // vehicle type (maybe if there were more types?)
         Node departure; // Node from where the vehicle departs (the hub)
         Node arrival; // Node where the vehicle should return (the hub again)
         double capacity; // How much the vehicle can carry
+        int number; // How many vehicles of the profile are available (-1 if not limited)
+        double maxTravelTime; // The latest time the vehicle has to be back in the hub
 };
 
 #endif
@@ -0,0 +1,135 @@
+"""
+    Regression checks of the gal executable, run by make check
+    Every case solves an instance and checks that the solution serves every customer exactly once, has no empty
+    route, does not overload its vehicles and reports the distance of its routes.
+"""
+
+import csv
+import json
+import math
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import xml.etree.ElementTree as ET
+
+GAL = "./gal"
+DATA_DIR = "./tests/data/"
+TIMEOUT = 60  # seconds of a run, a hanging solver fails the case
+
+# (instance, arguments of gal)
+CASES = [
+    # customers larger than the small vehicles, sweep dropped them and genetic crashed on the tours of sweep
+    ("A-n32-k05-heterogeneous.xml", ["--algorithm", "sweep", "--fleet", "heterogeneous"]),
+    ("A-n32-k05-heterogeneous.xml", ["--algorithm", "savings", "--fleet", "heterogeneous"]),
+    ("A-n32-k05-heterogeneous.xml", ["--algorithm", "genetic", "--fleet", "heterogeneous", "--seed", "1"]),
+    ("A-n32-k05-heterogeneous.xml", ["--algorithm", "genetic", "--fleet", "heterogeneous", "--seed", "2"]),
+    ("A-n32-k05-heterogeneous.xml", ["--algorithm", "genetic", "--fleet", "heterogeneous", "--seed", "3"]),
+    ("A-n32-k05-heterogeneous.xml", ["--algorithm", "lns", "--fleet", "heterogeneous", "--time-limit", "0.5"]),
+    ("A-n32-k05-heterogeneous.xml", ["--algorithm", "tabu", "--fleet", "heterogeneous", "--time-limit", "0.5"]),
+    ("A-n32-k05-heterogeneous.xml", ["--algorithm", "portfolio", "--fleet", "heterogeneous", "--time-limit", "0.5"]),
+    # the second depot serves three customers, too few for 50 distinct chromosomes, and genetic did not finish
+    ("A-n35-k06-two-depots.xml", ["--algorithm", "genetic"]),
+    ("A-n35-k06-two-depots.xml", ["--algorithm", "portfolio", "--time-limit", "0.5"]),
+    # clusters of four customers, too few for the genetic population, did not finish
+    ("clusters-n92-k10.xml", ["--algorithm", "genetic", "--decompose", "sectors", "--cluster-size", "4"]),
+    ("clusters-n92-k10.xml", ["--algorithm", "genetic", "--decompose", "kmeans", "--cluster-size", "4",
+                              "--reoptimize-boundaries"]),
+    # eleven routes that must fit ten vehicles, the first fit decreasing repacking left an empty route behind
+    ("clusters-n92-k10.xml", ["--algorithm", "tabu", "--time-limit", "0.001", "--max-vehicles", "10",
+                              "--initial-solution", DATA_DIR + "clusters-n92-k10-routes.json"]),
+]
+
+
+def load(instance):
+    root = ET.parse(instance).getroot()
+    coordinates = {int(node.get("id")): (float(node.find("cx").text), float(node.find("cy").text))
+                   for node in root.iter("node")}
+    demands = {int(request.get("node")): float(request.find("quantity").text) for request in root.iter("request")}
+    return coordinates, demands
+
+
+def solve(instance, arguments):
+    try:
+        return subprocess.run([GAL] + arguments + ["--output", "json", instance], capture_output=True, text=True,
+                              timeout=TIMEOUT)
+    except subprocess.TimeoutExpired:
+        return subprocess.CompletedProcess(arguments, -1, "", "no solution within %d s" % TIMEOUT)
+
+
+def check(instance, arguments):
+    run = solve(instance, arguments)
+    if run.returncode != 0:
+        return "exit code %d: %s" % (run.returncode, run.stderr.strip())
+    solution = json.loads(run.stdout.splitlines()[0])
+    coordinates, demands = load(instance)
+    capacities = solution.get("capacities")
+    depots = solution.get("depots")
+    served = []
+    distance = 0
+    for index, route in enumerate(solution["routes"]):
+        if not route:
+            return "empty route %d" % index
+        if capacities and sum(demands[customer] for customer in route) > capacities[index] + 1e-9:
+            return "overloaded route %d" % index
+        depot = depots[index] if depots else 1
+        stops = [depot] + route + [depot]
+        distance += sum(math.dist(coordinates[stops[i]], coordinates[stops[i + 1]]) for i in range(len(stops) - 1))
+        served += route
+    if sorted(served) != sorted(demands):
+        return "%d of %d customers served" % (len(set(served) & set(demands)), len(demands))
+    if abs(distance - solution["distance"]) > 1e-6 * max(1, distance):
+        return "reported distance %f, the routes have %f" % (solution["distance"], distance)
+    return None
+
+
+# (instance, arguments of gal, arguments of the second run) that must give the same routes
+REPEATED = [
+    # the genetic operators were rewarded per CPU time, so the seed did not fix the solution
+    ("A-n32-k05-heterogeneous.xml", ["--algorithm", "genetic", "--seed", "7", "--jobs", "1"], ["--jobs", "1"]),
+    ("A-n32-k05-heterogeneous.xml", ["--algorithm", "genetic", "--seed", "7", "--jobs", "1"], ["--jobs", "4"]),
+    # with more workers the distances of the offspring to the members are calculated in parallel
+    ("A-n32-k05-heterogeneous.xml", ["--algorithm", "genetic", "--generational", "--seed", "3", "--jobs", "1"],
+     ["--jobs", "4"]),
+]
+
+
+def routes(instance, arguments):
+    run = solve(instance, arguments)
+    return json.loads(run.stdout.splitlines()[0])["routes"] if run.returncode == 0 else run.stderr.strip()
+
+
+def repeat(instance, arguments, changed):
+    first = routes(instance, arguments)
+    second = routes(instance, arguments[:-len(changed)] + changed)
+    return None if first == second else "the routes differ"
+
+
+def batch_csv():
+    """The instance path with a separator and quotes is one quoted field of the batch CSV (RFC 4180)"""
+    with tempfile.TemporaryDirectory() as directory:
+        path = os.path.join(directory, 'clusters, "copy".xml')
+        shutil.copy(DATA_DIR + "clusters-n92-k10.xml", path)
+        run = subprocess.run([GAL, "batch", directory, "--algorithm", "savings"], capture_output=True, text=True)
+        if run.returncode != 0:
+            return "exit code %d: %s" % (run.returncode, run.stderr.strip())
+        header, row = list(csv.reader(run.stdout.splitlines()))
+        if len(row) != len(header) or row[0] != path:
+            return "the record has %d of %d fields, instance %s" % (len(row), len(header), row[0])
+    return None
+
+
+failures = 0
+for instance, arguments in CASES:
+    error = check(DATA_DIR + instance, arguments)
+    print("%s %s: %s" % (instance, " ".join(arguments), error or "ok"))
+    failures += error is not None
+for instance, arguments, changed in REPEATED:
+    error = repeat(DATA_DIR + instance, arguments, changed)
+    print("%s %s, again with %s: %s" % (instance, " ".join(arguments), " ".join(changed), error or "ok"))
+    failures += error is not None
+error = batch_csv()
+print("batch csv: %s" % (error or "ok"))
+failures += error is not None
+sys.exit(1 if failures else 0)
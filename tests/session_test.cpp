@@ -0,0 +1,148 @@
+/**
+ * Check of the incremental re-optimization (see src/session.hpp), run by make check
+ * A session on a small instance goes through added, cancelled and changed customers. After every event the solution
+ * has to serve every active customer exactly once within the capacities with the distance of its routes, and at the
+ * end it has to stay close to a full re-solve of the same customers.
+**/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/session.hpp"
+#include "../src/solver.hpp"
+
+using namespace std;
+
+static const char* INSTANCE = "data/A-n32-k05.xml";
+// The contract of the bounded repair: after these events (the capacity is almost used up) the session stays within
+// 10 % of the genetic re-solve with the same seed, it ends about 4 % above it. The bound catches the repair without
+// the exchanges of the route tails (12 %). It is not met with every seed: the repair never dissolves a route, and
+// a customer that fits into no route keeps the route opened for it (15 % with the seed 3).
+static const double RESOLVE_TOLERANCE = 1.10;
+
+/**
+ * Checks the solution of the session against the problem with all events applied.
+ * @param session the session
+ * @param active the IDs of the customers that were not cancelled
+ * @param options options of the session (the distances)
+ * @throws runtime_error describing the first violation found
+ */
+static void checkSolution(const Session& session, const vector<int>& active, const SolverOptions& options) {
+    const Problem& problem = session.problem();
+    Solution solution = session.solution();
+    DistanceMatrix matrix = Solver::distanceMatrix(problem, options);
+    vector<int> visits(problem.nodes.size() + 1, 0);
+    double distance = 0;
+    for (size_t r = 0; r < solution.routes.size(); r++) {
+        auto& route = solution.routes[r];
+        if (route.empty()) {
+            throw runtime_error("The route " + to_string(r) + " is empty");
+        }
+        double load = 0;
+        int previous = 0;
+        for (auto& customer : route) {
+            visits[customer]++;
+            load += problem.requests[customer-2].quantity;
+            distance += matrix[previous][customer-1];
+            previous = customer - 1;
+        }
+        distance += matrix[previous][0];
+        if (load > problem.vehicleCapacity() + 1e-9) {
+            throw runtime_error("The route " + to_string(r) + " carries " + to_string(load));
+        }
+    }
+    vector<int> expected(problem.nodes.size() + 1, 0);
+    for (auto& customer : active) {
+        expected[customer] = 1;
+    }
+    for (size_t customer = 2; customer <= problem.nodes.size(); customer++) {
+        if (visits[customer] != expected[customer]) {
+            throw runtime_error("The customer " + to_string(customer) + " is visited " + to_string(visits[customer])
+                                + " times instead of " + to_string(expected[customer]));
+        }
+    }
+    if (abs(distance - solution.distance) > 1e-6 * distance) {
+        throw runtime_error("The solution reports the distance " + to_string(solution.distance) + ", its routes have "
+                            + to_string(distance));
+    }
+}
+
+/**
+ * Solves the active customers from scratch.
+ * @param session the session
+ * @param active the IDs of the customers that were not cancelled
+ * @param options options of the session
+ * @return the distance of the solution
+ */
+static double resolve(const Session& session, const vector<int>& active, const SolverOptions& options) {
+    const Problem& problem = session.problem();
+    Problem compact;
+    compact.name = problem.name;
+    compact.addDepot(problem.nodes[0].x, problem.nodes[0].y);
+    compact.addVehicle(problem.vehicleCapacity());
+    for (auto& customer : active) {
+        const Node& node = problem.nodes[customer-1];
+        const Request& request = problem.requests[customer-2];
+        compact.addCustomer(node.x, node.y, request.quantity, request.ready, request.due, request.service);
+    }
+    return Solver::solve(compact, options).distance;
+}
+
+int main() {
+    SolverOptions options;
+    options.algorithm = "genetic";
+    Problem problem = Problem::load(INSTANCE);
+    vector<int> active;
+    for (size_t customer = 2; customer <= problem.nodes.size(); customer++) {
+        active.push_back(customer);
+    }
+    auto cancel = [&](int customer) {
+        active.erase(find(active.begin(), active.end(), customer));
+    };
+
+    try {
+        Session session(problem, options);
+        checkSolution(session, active, options);
+        // customers in the middle and at the borders of the instance, one of them large
+        active.push_back(session.addCustomer(50, 50, 10));
+        checkSolution(session, active, options);
+        active.push_back(session.addCustomer(5, 95, 40));
+        checkSolution(session, active, options);
+        active.push_back(session.addCustomer(95, 5, 3));
+        checkSolution(session, active, options);
+        session.removeCustomer(5);
+        cancel(5);
+        checkSolution(session, active, options);
+        session.removeCustomer(active.back());
+        cancel(active.back());
+        checkSolution(session, active, options);
+        // a demand that overloads its route and one that shrinks
+        session.changeDemand(10, 60);
+        checkSolution(session, active, options);
+        session.changeDemand(20, 1);
+        checkSolution(session, active, options);
+        // the first time window switches the routes to their timing
+        active.push_back(session.addCustomer(60, 20, 5, 0, 100, 10));
+        checkSolution(session, active, options);
+        session.removeCustomer(15);
+        cancel(15);
+        checkSolution(session, active, options);
+
+        double incremental = session.solution().distance;
+        double full = resolve(session, active, options);
+        cout << "session: " << incremental << ", re-solve: " << full << endl;
+        if (incremental > full * RESOLVE_TOLERANCE) {
+            long percent = lround((RESOLVE_TOLERANCE - 1) * 100);
+            throw runtime_error("The incremental solution is more than " + to_string(percent)
+                                + " % longer than the re-solve");
+        }
+    } catch (const exception& e) {
+        cerr << "session: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    cout << "session: ok" << endl;
+    return EXIT_SUCCESS;
+}